@@ -11,16 +11,24 @@ xcopy /Y \"$(TargetPath)\" \"$(GTA_" .. gameAbbr .. "_DIR)\\scripts\" \r\n\
 end
 
 workspace "III.VC.SA.WindowedMode"
-   configurations { "Release", "Gta3", "GtaVC", "GtaSA" }
-   platforms { "Win32" }
-   architecture "x32"
-   characterset ("MBCS")
-   staticruntime "on"
+   if os.istarget("windows") then
+      configurations { "Release", "Gta3", "GtaVC", "GtaSA" }
+      platforms { "Win32" }
+      architecture "x32"
+      characterset ("MBCS")
+      staticruntime "on"
+      buildoptions {"-std:c++latest"}
+   else -- only the tests build elsewhere, "premake5 gmake2"
+      configurations { "Release", "TSan" }
+      platforms { "x64" }
+      architecture "x86_64"
+      cppdialect "C++20"
+   end
    location "build"
    objdir ("build/obj")
    buildlog ("build/log/%{prj.name}.log")
-   buildoptions {"-std:c++latest"}
-      
+
+if os.istarget("windows") then
 project "III.VC.SA.WindowedMode"
    kind "SharedLib"
    language "C++"
@@ -66,3 +74,22 @@ project "III.VC.SA.WindowedMode"
       defines { "NDEBUG" }
       optimize "on"
       targetdir "data"
+end
+
+project "Tests"
+   kind "ConsoleApp"
+   language "C++"
+   targetdir "build/bin/%{cfg.buildcfg}"
+
+   files { "tests/*.h", "tests/*.cpp" }
+   includedirs { "source", "tests" }
+   optimize "on"
+   warnings "Extra" -- portable headers are kept warning clean
+
+   filter "system:not windows"
+      links { "pthread" }
+
+   filter "configurations:TSan"
+      buildoptions { "-fsanitize=thread" }
+      linkoptions { "-fsanitize=thread" }
+      symbols "on"
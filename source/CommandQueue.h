@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Bounded lock-free multi-producer single-consumer queue.
+// Each cell carries a sequence number telling whether it is free for the producer owning that position
+// or holds data ready for the consumer, so producers only contend on a single compare-exchange.
+// Pop() must not be called from multiple threads at once.
+template <class T, uint32_t Capacity>
+class CommandQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be power of 2");
+
+public:
+	CommandQueue()
+	{
+		for (uint32_t i = 0; i < Capacity; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// returns false if the queue is full
+	bool Push(const T& item)
+	{
+		auto pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell = cells[pos & (Capacity - 1)];
+			auto diff = int32_t(cell.sequence.load(std::memory_order_acquire) - pos);
+
+			if (diff == 0) // free, try to claim it
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.data = item;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0) // not consumed yet since last lap
+				return false;
+			else // other producer took it
+				pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// returns false if the queue is empty
+	bool Pop(T& item)
+	{
+		auto& cell = cells[dequeuePos & (Capacity - 1)];
+		if (int32_t(cell.sequence.load(std::memory_order_acquire) - (dequeuePos + 1)) < 0)
+			return false; // empty or still being written
+
+		item = cell.data;
+		cell.sequence.store(dequeuePos + Capacity, std::memory_order_release);
+		dequeuePos++;
+		return true;
+	}
+
+protected:
+	struct Cell
+	{
+		std::atomic<uint32_t> sequence;
+		T data;
+	};
+
+	Cell cells[Capacity];
+	alignas(64) std::atomic<uint32_t> enqueuePos = 0;
+	alignas(64) uint32_t dequeuePos = 0; // consumer only
+};
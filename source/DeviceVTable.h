@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "PatchTransaction.h"
+
+// Virtual table slots of the IDirect3DDevice8/9 methods hooked by the plugin
+template <bool D3D9>
+struct DeviceVTable
+{
+	static constexpr size_t Reset = D3D9 ? 16 : 14;
+	static constexpr size_t Present = D3D9 ? 17 : 15;
+
+	struct Hooks
+	{
+		uintptr_t reset;
+		uintptr_t present;
+	};
+
+	// patches redirecting the slots to the hooks, returns the original functions
+	static Hooks Redirect(uintptr_t* vTable, const Hooks& hooks, PatchOp (&patches)[2])
+	{
+		patches[0] = PatchOp::Write((uintptr_t)&vTable[Reset], hooks.reset);
+		patches[1] = PatchOp::Write((uintptr_t)&vTable[Present], hooks.present);
+		return { vTable[Reset], vTable[Present] };
+	}
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Tracks window focus and minimization to decide how the game should render while in background.
+// Fed from window messages on the window thread, queried once per frame by the present hook which may run on another one.
+class FocusThrottle
+{
+public:
+	enum State : uint8_t
+	{
+		Active, // focused, full speed
+		Background, // visible but not focused, render at reduced rate
+		Minimized, // nothing to show
+	};
+
+	bool enabled = true; // settings, set before the game starts
+	bool skipPresentMinimized = true; // don't present frames at all while minimized
+
+	// WM_ACTIVATE
+	void OnActivate(bool active, bool minimized)
+	{
+		focused = active;
+		this->minimized = minimized;
+		Update();
+	}
+
+	// WM_SIZE
+	void OnMinimize(bool minimized)
+	{
+		this->minimized = minimized;
+		Update();
+	}
+
+	State GetState() const
+	{
+		return state.load(std::memory_order_relaxed);
+	}
+
+	bool IsThrottled() const
+	{
+		return GetState() != State::Active;
+	}
+
+	bool ShouldPresent() const
+	{
+		return !(GetState() == State::Minimized && skipPresentMinimized);
+	}
+
+	// true once after returning to full speed, so pending throttled frame deadlines can be dropped
+	bool ConsumeResume()
+	{
+		return resumed.exchange(false, std::memory_order_relaxed);
+	}
+
+protected:
+	std::atomic<State> state = State::Active; // published to the present hook
+	std::atomic<bool> resumed = false;
+	bool focused = true; // window thread only
+	bool minimized = false;
+
+	void Update()
+	{
+		auto newState = !enabled ? State::Active :
+			minimized ? State::Minimized :
+			focused ? State::Active : State::Background;
+
+		auto prevState = state.exchange(newState, std::memory_order_relaxed);
+		if (prevState != State::Active && newState == State::Active)
+			resumed.store(true, std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <stdint.h>
+
+enum class PacingStrategy : uint8_t
+{
+	Sleep, // lowest CPU usage, precision limited by the clock's sleep granularity
+	Hybrid, // sleep until close to the deadline, then spin
+	BusyWait, // spin whole time, most precise
+};
+
+// Deadline based frame pacer.
+// Next present time is scheduled on a fixed cadence instead of measuring from the previous frame,
+// so sleep overshoots don't accumulate. With the hybrid strategy waiting is done by coarse sleeping
+// while the deadline is far, followed by spinning on the clock for the last part.
+//
+// Clock requirements:
+//   int64_t Now();          monotonic time in nanoseconds
+//   void Sleep(int64_t ns); coarse sleep, may oversleep up to the clock's granularity
+template <class Clock>
+class FramePacer
+{
+public:
+	static constexpr int64_t NanosecondsPerSecond = 1000000000;
+
+	Clock clock;
+	PacingStrategy strategy = PacingStrategy::Hybrid;
+	int64_t spinThreshold = 2000000; // stop sleeping this many ns before the deadline (hybrid strategy)
+
+	FramePacer() = default;
+	FramePacer(const Clock& clock) : clock(clock)
+	{
+	}
+
+	// frames per second, 0 to disable
+	void SetTarget(unsigned int fps)
+	{
+		int64_t newInterval = fps ? NanosecondsPerSecond / fps : 0;
+		if (newInterval != interval)
+		{
+			interval = newInterval;
+			Reset();
+		}
+	}
+
+	unsigned int GetTarget() const
+	{
+		return interval ? (unsigned int)(NanosecondsPerSecond / interval) : 0;
+	}
+
+	int64_t GetInterval() const
+	{
+		return interval;
+	}
+
+	// forget the cadence, next Wait() returns immediately
+	void Reset()
+	{
+		deadline = 0;
+	}
+
+	// block until the deadline of current frame, returns time spent waiting in ns
+	int64_t Wait()
+	{
+		if (interval <= 0)
+			return 0;
+
+		auto now = clock.Now();
+		auto start = now;
+
+		// first frame or stalled for more than a whole frame: restart the cadence
+		if (deadline == 0 || now - deadline >= interval)
+			deadline = now;
+
+		switch (strategy)
+		{
+			case PacingStrategy::Sleep:
+				while (now < deadline)
+				{
+					clock.Sleep(deadline - now);
+					now = clock.Now();
+				}
+				break;
+
+			case PacingStrategy::Hybrid:
+				while (deadline - now > spinThreshold)
+				{
+					clock.Sleep(deadline - now - spinThreshold);
+					now = clock.Now();
+				}
+				[[fallthrough]];
+
+			case PacingStrategy::BusyWait:
+				while (now < deadline)
+					now = clock.Now();
+				break;
+		}
+
+		deadline += interval;
+		return now - start;
+	}
+
+protected:
+	int64_t interval = 0; // ns
+	int64_t deadline = 0; // ns, time of the next present
+};
+
+// Frame pacer with separate framerate targets for different game situations
+template <class Clock>
+class FrameLimiter
+{
+public:
+	enum Context : uint8_t
+	{
+		Gameplay,
+		Menu,
+		Unfocused,
+		ContextCount
+	};
+
+	static constexpr unsigned int RefreshRate = ~0u; // target following refresh rate of the monitor
+
+	FramePacer<Clock> pacer;
+	unsigned int targets[ContextCount] = {}; // frames per second, 0 for unlimited
+	unsigned int refreshRate = 0; // of the monitor showing the game, 0 if unknown
+
+	FrameLimiter() = default;
+	FrameLimiter(const Clock& clock) : pacer(clock)
+	{
+	}
+
+	// target as written in the config file, negative values follow the refresh rate
+	static unsigned int ConfigTarget(int value)
+	{
+		return value < 0 ? RefreshRate : (unsigned int)value;
+	}
+
+	// returns time spent waiting in ns
+	int64_t Limit(Context context)
+	{
+		pacer.SetTarget(targets[context] == RefreshRate ? refreshRate : targets[context]);
+		return pacer.Wait();
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include "FramePacer.h"
+#include "FocusThrottle.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
+#include "InputLatency.h"
+#include "WindowController.h"
+
+// Per frame work of the present hook around the game's original Present: frame time statistics,
+// focus throttling, input latency, frame limiting and tracing. Independent of the D3D version.
+template <class Clock>
+class FramePresenter
+{
+public:
+	Clock clock;
+	FrameTimeRecorder frameStats;
+	FrameTimeSummary frameSummary; // last second, shown in the window title
+	int64_t frameSummaryTime = 0;
+	FrameTrace frameTrace;
+	InputLatencyTracker inputLatency;
+	FrameLimiter<Clock> frameLimiter;
+	FocusThrottle focusThrottle;
+
+	FramePresenter() = default;
+	FramePresenter(const Clock& clock) : clock(clock), frameLimiter(clock)
+	{
+	}
+
+	// hook entry, returns true once per second when the summary got refreshed
+	bool Begin(FrameTraceRecord& trace)
+	{
+		auto now = trace.hookEntry = clock.Now();
+
+		frameStats.Frame(now);
+		if (now - frameSummaryTime < FramePacer<Clock>::NanosecondsPerSecond)
+			return false;
+
+		frameSummary = frameStats.Summarize(FramePacer<Clock>::NanosecondsPerSecond);
+		frameSummaryTime = now;
+		return true;
+	}
+
+	// calls the original Present unless the window is minimized
+	template <class Func>
+	auto Present(FrameTraceRecord& trace, Func&& present)
+	{
+		decltype(present()) result = {};
+
+		trace.presentBegin = clock.Now();
+		if (focusThrottle.ShouldPresent()) // nothing to show while minimized
+		{
+			result = present();
+			trace.presentEnd = clock.Now();
+			inputLatency.Present(trace.presentEnd);
+		}
+		else
+			trace.presentEnd = clock.Now();
+
+		return result;
+	}
+
+	// limits framerate, returning to the game afterwards
+	void End(FrameTraceRecord& trace, bool menu)
+	{
+		if (focusThrottle.ConsumeResume())
+			frameLimiter.pacer.Reset(); // full speed right away after refocus
+
+		auto context = menu ? frameLimiter.Menu : frameLimiter.Gameplay;
+		if (frameLimiter.targets[frameLimiter.Unfocused] > 0 && focusThrottle.IsThrottled())
+			context = frameLimiter.Unfocused;
+
+		frameLimiter.Limit(context);
+
+		trace.limiterEnd = clock.Now();
+		frameTrace.Add(trace);
+	}
+
+	// whole present hook, prepare(summaryUpdated) runs before presenting. present(rect) gets the back buffer area
+	// in the client area (fixed back buffer or resize pending), nullptr if it's shown as is or scale is false
+	template <class Prepare, class Func>
+	auto Frame(const WindowController& controller, bool scale, bool menu, Prepare&& prepare, Func&& present)
+	{
+		FrameTraceRecord trace;
+		prepare(Begin(trace));
+
+		ScaleRect rect;
+		bool scaled = scale && controller.GetPresentRect(rect);
+		auto result = Present(trace, [&] { return present(scaled ? &rect : nullptr); });
+
+		frameLimiter.refreshRate = controller.refreshRate;
+		End(trace, menu);
+		return result;
+	}
+};
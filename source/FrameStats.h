@@ -0,0 +1,167 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Log-bucket (HDR style) histogram of durations in nanoseconds.
+// Every power of two range is split into SubBucketCount linear buckets, giving ~3% precision over the whole range.
+class FrameTimeHistogram
+{
+public:
+	static constexpr int SubBucketBits = 5;
+	static constexpr int SubBucketCount = 1 << SubBucketBits;
+	static constexpr int MaxValueBits = 40; // ~18 minutes
+	static constexpr int BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+	static int BucketIndex(uint64_t value)
+	{
+		if (value < SubBucketCount)
+			return (int)value;
+
+		int msb = 63;
+		while (!(value >> msb)) msb--;
+
+		int shift = msb - SubBucketBits;
+		int index = shift * SubBucketCount + (int)(value >> shift);
+		return index < BucketCount ? index : BucketCount - 1;
+	}
+
+	// middle of the value range covered by the bucket
+	static uint64_t BucketValue(int index)
+	{
+		if (index < 2 * SubBucketCount)
+			return index;
+
+		int shift = index / SubBucketCount - 1;
+		uint64_t lower = uint64_t(index % SubBucketCount + SubBucketCount) << shift;
+		return lower + (uint64_t(1) << shift) / 2;
+	}
+
+	void Add(uint64_t value)
+	{
+		counts[BucketIndex(value)]++;
+		total++;
+	}
+
+	void Clear()
+	{
+		*this = {};
+	}
+
+	uint64_t GetCount() const
+	{
+		return total;
+	}
+
+	// quantile in range 0.0 - 1.0
+	uint64_t Percentile(double quantile) const
+	{
+		if (!total)
+			return 0;
+
+		auto rank = uint64_t(quantile * total + 0.5);
+		if (rank < 1) rank = 1;
+		if (rank > total) rank = total;
+
+		uint64_t sum = 0;
+		for (int i = 0; i < BucketCount; i++)
+		{
+			sum += counts[i];
+			if (sum >= rank)
+				return BucketValue(i);
+		}
+		return BucketValue(BucketCount - 1);
+	}
+
+protected:
+	uint32_t counts[BucketCount] = {};
+	uint64_t total = 0;
+};
+
+struct FrameTimeSummary
+{
+	uint32_t frames = 0;
+	int64_t duration = 0; // ns, sum of all frame times
+	int64_t avg = 0;
+	int64_t p50 = 0;
+	int64_t p99 = 0;
+	int64_t p999 = 0;
+	int64_t max = 0;
+
+	unsigned int Fps() const
+	{
+		return duration > 0 ? (unsigned int)((frames * 1000000000ll + duration / 2) / duration) : 0;
+	}
+};
+
+// Records frame times into a fixed size ring buffer.
+// Frame() is called from the render thread only, Summarize() may be called from any thread without locking
+// (concurrently overwritten oldest entries only skew the result slightly).
+class FrameTimeRecorder
+{
+public:
+	static constexpr uint32_t Capacity = 4096; // power of 2
+
+	// call once per frame with current time in ns
+	void Frame(int64_t now)
+	{
+		if (prevTime)
+			Record(now - prevTime);
+		prevTime = now;
+	}
+
+	void Record(int64_t delta)
+	{
+		auto value = uint32_t(delta < 0 ? 0 : delta > UINT32_MAX ? UINT32_MAX : delta);
+		auto index = writeIndex.load(std::memory_order_relaxed);
+		ring[index & (Capacity - 1)].store(value, std::memory_order_relaxed);
+		writeIndex.store(index + 1, std::memory_order_release);
+
+		session.Add(value);
+	}
+
+	// drop the frame time spanning a pause (loading, minimized window etc.)
+	void Restart()
+	{
+		prevTime = 0;
+	}
+
+	// statistics of the most recent frames covering the given time window
+	FrameTimeSummary Summarize(int64_t window) const
+	{
+		FrameTimeSummary result;
+		FrameTimeHistogram histogram;
+
+		auto end = writeIndex.load(std::memory_order_acquire);
+		auto count = end < Capacity ? end : Capacity;
+
+		for (uint32_t i = 1; i <= count && result.duration < window; i++)
+		{
+			int64_t value = ring[(end - i) & (Capacity - 1)].load(std::memory_order_relaxed);
+			histogram.Add(value);
+			result.frames++;
+			result.duration += value;
+			if (value > result.max) result.max = value;
+		}
+
+		if (result.frames)
+		{
+			result.avg = result.duration / result.frames;
+			result.p50 = histogram.Percentile(0.5);
+			result.p99 = histogram.Percentile(0.99);
+			result.p999 = histogram.Percentile(0.999);
+		}
+		return result;
+	}
+
+	// histogram of all frames since start, render thread only
+	const FrameTimeHistogram& Session() const
+	{
+		return session;
+	}
+
+protected:
+	std::atomic<uint32_t> ring[Capacity] = {};
+	std::atomic<uint32_t> writeIndex = 0;
+	int64_t prevTime = 0;
+	FrameTimeHistogram session;
+};
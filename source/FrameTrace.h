@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// timestamps of single frame passing through the present hook, in ns
+struct FrameTraceRecord
+{
+	int64_t hookEntry;
+	int64_t presentBegin; // just before original Present
+	int64_t presentEnd; // original Present returned
+	int64_t limiterEnd; // frame limiter done, returning to the game
+};
+
+// Preallocated ring of the most recent frame traces.
+// Recording never allocates, dumping produces Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// Not synchronized, dumped from the thread adding the records.
+class FrameTrace
+{
+public:
+	static constexpr uint32_t Capacity = 8192; // power of 2
+
+	void Add(const FrameTraceRecord& record)
+	{
+		records[count & (Capacity - 1)] = record;
+		count++;
+	}
+
+	uint32_t GetCount() const
+	{
+		return count < Capacity ? count : Capacity;
+	}
+
+	// oldest record has index 0
+	const FrameTraceRecord& Get(uint32_t index) const
+	{
+		return records[(count - GetCount() + index) & (Capacity - 1)];
+	}
+
+	void Clear()
+	{
+		count = 0;
+	}
+
+	// Spans written per frame:
+	//   Game     previous frame returned to the game -> hook entry
+	//   Hook     hook entry -> original Present called
+	//   Present  time spent inside original Present (driver, vsync wait)
+	//   Limiter  frame limiter wait
+	void WriteJson(FILE* file) const
+	{
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+		auto origin = GetCount() ? Get(0).hookEntry : 0;
+		bool first = true;
+		auto span = [&](const char* name, int64_t begin, int64_t end)
+		{
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", name, (begin - origin) / 1000.0, (end - begin) / 1000.0);
+			first = false;
+		};
+
+		for (uint32_t i = 0; i < GetCount(); i++)
+		{
+			auto& frame = Get(i);
+			if (i > 0) span("Game", Get(i - 1).limiterEnd, frame.hookEntry);
+			span("Hook", frame.hookEntry, frame.presentBegin);
+			span("Present", frame.presentBegin, frame.presentEnd);
+			span("Limiter", frame.presentEnd, frame.limiterEnd);
+		}
+
+		fputs("\n]}\n", file);
+	}
+
+protected:
+	FrameTraceRecord records[Capacity];
+	uint32_t count = 0;
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <stdint.h>
+
+// thickness of each window edge in pixels
+struct GeometryInsets
+{
+	int32_t left, top, right, bottom;
+};
+
+// value given for one DPI converted to another, rounded to nearest like MulDiv
+static inline int32_t ScaleForDpi(int32_t value, uint32_t fromDpi, uint32_t toDpi)
+{
+	if (fromDpi == toDpi || !fromDpi)
+		return value;
+
+	auto scaled = int64_t(value) * toDpi;
+	auto half = int64_t(fromDpi / 2);
+	return int32_t(scaled >= 0 ? (scaled + half) / fromDpi : -((half - scaled) / fromDpi));
+}
+
+static inline GeometryInsets ScaleForDpi(const GeometryInsets& insets, uint32_t fromDpi, uint32_t toDpi)
+{
+	return {
+		ScaleForDpi(insets.left, fromDpi, toDpi),
+		ScaleForDpi(insets.top, fromDpi, toDpi),
+		ScaleForDpi(insets.right, fromDpi, toDpi),
+		ScaleForDpi(insets.bottom, fromDpi, toDpi)
+	};
+}
+
+// platform queries the cache is filled from
+class GeometrySource
+{
+public:
+	virtual ~GeometrySource() = default;
+
+	virtual GeometryInsets AdjustFrame(uint32_t style, uint32_t exStyle, uint32_t dpi) = 0; // frame around client area
+	virtual bool QueryPadding(GeometryInsets& padding) = 0; // invisible resize borders, false if not available yet
+	virtual uint32_t QueryDpi() = 0;
+	virtual const void* QueryMonitor() = 0;
+};
+
+// Caches window frame metrics. They only depend on window styles, DPI and monitor,
+// so the cache is invalidated by style, DPI and display change messages instead of being queried on every use.
+class GeometryCache
+{
+public:
+	struct Key
+	{
+		uint32_t style;
+		uint32_t exStyle;
+		uint32_t dpi;
+		const void* monitor;
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	uint32_t queries = 0; // number of platform queries made
+
+	GeometryCache(GeometrySource& source) : source(source)
+	{
+	}
+
+	GeometryInsets GetFrame(uint32_t style, uint32_t exStyle)
+	{
+		auto key = MakeKey(style, exStyle);
+		if (!frameValid || frameKey != key)
+		{
+			frame = source.AdjustFrame(style, exStyle, key.dpi);
+			frameKey = key;
+			frameValid = true;
+			queries++;
+		}
+		return frame;
+	}
+
+	GeometryInsets GetPadding(uint32_t style, uint32_t exStyle)
+	{
+		auto key = MakeKey(style, exStyle);
+		if (!paddingValid || paddingKey != key)
+		{
+			padding = {};
+			paddingValid = source.QueryPadding(padding); // don't remember failures
+			paddingKey = key;
+			queries++;
+		}
+		return padding;
+	}
+
+	// WM_STYLECHANGED, WM_DPICHANGED, WM_DISPLAYCHANGE or new window
+	void Invalidate()
+	{
+		environmentValid = false;
+		frameValid = false;
+		paddingValid = false;
+	}
+
+protected:
+	GeometrySource& source;
+
+	bool environmentValid = false;
+	uint32_t dpi = 0;
+	const void* monitor = nullptr;
+
+	bool frameValid = false;
+	Key frameKey = {};
+	GeometryInsets frame = {};
+
+	bool paddingValid = false;
+	Key paddingKey = {};
+	GeometryInsets padding = {};
+
+	Key MakeKey(uint32_t style, uint32_t exStyle)
+	{
+		if (!environmentValid)
+		{
+			dpi = source.QueryDpi();
+			monitor = source.QueryMonitor();
+			environmentValid = true;
+			queries += 2;
+		}
+		return { style, exStyle, dpi, monitor };
+	}
+};
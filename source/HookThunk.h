@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define HOOK_CDECL __cdecl
+#elif defined(__i386__)
+#define HOOK_CDECL __attribute__((cdecl))
+#else
+#define HOOK_CDECL // single calling convention, thunks only run on x86 anyway
+#endif
+
+// x86 register encoding order
+enum class HookReg : uint8_t { eax, ecx, edx, ebx, esp, ebp, esi, edi };
+
+// Registers saved by a hook thunk and passed to the patch functor.
+// Caller saved registers (eax, ecx, edx) and flags are always preserved, callee saved ones only if listed,
+// as the compiled functor keeps them intact anyway.
+template <HookReg... Used>
+struct HookRegs
+{
+	static constexpr uint8_t Volatile = 1 << (int)HookReg::eax | 1 << (int)HookReg::ecx | 1 << (int)HookReg::edx;
+	static constexpr uint8_t Mask = Volatile | (0 | ... | (1 << (int)Used));
+	static_assert(!(Mask & 1 << (int)HookReg::esp), "Stack pointer can not be saved by thunk");
+
+	static constexpr size_t Count()
+	{
+		size_t count = 0;
+		for (int i = 0; i < 8; i++) count += (Mask >> i) & 1;
+		return count;
+	}
+
+	// values as pushed by the thunk, in register encoding order
+	uint32_t values[Count()];
+
+	template <HookReg Reg>
+	uint32_t& Get()
+	{
+		static_assert(Mask & 1 << (int)Reg, "Register not saved by this thunk");
+		size_t index = 0;
+		for (int i = 0; i < (int)Reg; i++) index += (Mask >> i) & 1;
+		return values[index];
+	}
+};
+
+// Emits machine code of a mid-function hook thunk:
+//   pushfd; push <saved registers>; push esp; call callback; add esp, 4; pop <saved registers>; popfd; jmp returnAddress
+// Callback is cdecl void(uint32_t* values), values are in register encoding order.
+class HookThunkBuilder
+{
+public:
+	static constexpr size_t MaxSize = 32;
+
+	static constexpr size_t GetSize(uint8_t mask)
+	{
+		size_t count = 0;
+		for (int i = 0; i < 8; i++) count += (mask >> i) & 1;
+		return 1 + count + 1 + 5 + 3 + count + 1 + 5;
+	}
+
+	// code is written into buffer which will be executed at codeAddress, returns bytes written or 0 if it does not fit
+	static size_t Build(uint8_t* code, size_t capacity, uintptr_t codeAddress, uint8_t mask, uintptr_t callback, uintptr_t returnAddress)
+	{
+		if (mask & 1 << (int)HookReg::esp || GetSize(mask) > capacity)
+			return 0;
+
+		size_t size = 0;
+		code[size++] = 0x9C; // pushfd
+
+		for (int reg = 7; reg >= 0; reg--) // last pushed is at the lowest address
+		{
+			if (mask & 1 << reg) code[size++] = uint8_t(0x50 + reg); // push reg
+		}
+
+		code[size++] = 0x54; // push esp, pointer to saved values
+		size = EmitRelative(code, size, codeAddress, 0xE8, callback); // call
+		code[size++] = 0x83; code[size++] = 0xC4; code[size++] = 0x04; // add esp, 4
+
+		for (int reg = 0; reg < 8; reg++)
+		{
+			if (mask & 1 << reg) code[size++] = uint8_t(0x58 + reg); // pop reg
+		}
+
+		code[size++] = 0x9D; // popfd
+		size = EmitRelative(code, size, codeAddress, 0xE9, returnAddress); // jmp
+		return size;
+	}
+
+protected:
+	static size_t EmitRelative(uint8_t* code, size_t size, uintptr_t codeAddress, uint8_t opcode, uintptr_t target)
+	{
+		auto offset = uint32_t(target - (codeAddress + size + 5));
+		code[size] = opcode;
+		memcpy(code + size + 1, &offset, sizeof(offset));
+		return size + 5;
+	}
+};
+
+// adapts patch functor taking its HookRegs type (Patch::Regs) to thunk callback
+template <class Patch>
+struct HookThunkCallback
+{
+	static void HOOK_CDECL Invoke(uint32_t* values)
+	{
+		Patch()(*reinterpret_cast<typename Patch::Regs*>(values));
+	}
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include "FrameStats.h"
+
+enum class InputClass : uint8_t
+{
+	Keyboard,
+	MouseButton,
+	MouseMove,
+	RawMouse,
+	Count
+};
+
+struct InputLatencySummary
+{
+	uint64_t events = 0;
+	int64_t p50 = 0;
+	int64_t p95 = 0;
+	int64_t p99 = 0;
+};
+
+// Measures time from input event arrival to the end of the next present, separately for each input class.
+// Not thread safe, events and presents come from the game's window thread, summaries are taken by the present. Times are in ns.
+class InputLatencyTracker
+{
+public:
+	static constexpr uint32_t MaxPending = 512; // per class between two presents, more events are only counted
+
+	uint32_t dropped = 0;
+
+	void Input(InputClass type, int64_t now)
+	{
+		auto& queue = pending[(int)type];
+		if (queue.count < MaxPending)
+			queue.times[queue.count++] = now;
+		else
+			dropped++;
+	}
+
+	// every pending event is matched with this present
+	void Present(int64_t now)
+	{
+		for (int type = 0; type < (int)InputClass::Count; type++)
+		{
+			auto& queue = pending[type];
+			for (uint32_t i = 0; i < queue.count; i++)
+			{
+				auto latency = now - queue.times[i];
+				histograms[type].Add(latency > 0 ? latency : 0);
+			}
+			queue.count = 0;
+		}
+	}
+
+	InputLatencySummary Summarize(InputClass type) const
+	{
+		auto& histogram = histograms[(int)type];
+
+		InputLatencySummary summary;
+		summary.events = histogram.GetCount();
+		summary.p50 = histogram.Percentile(0.50);
+		summary.p95 = histogram.Percentile(0.95);
+		summary.p99 = histogram.Percentile(0.99);
+		return summary;
+	}
+
+	static const char* GetName(InputClass type)
+	{
+		static const char* names[] = { "Keyboard", "Mouse button", "Mouse move", "Raw mouse" };
+		return names[(int)type];
+	}
+
+	void Clear()
+	{
+		for (int type = 0; type < (int)InputClass::Count; type++)
+		{
+			pending[type].count = 0;
+			histograms[type].Clear();
+		}
+		dropped = 0;
+	}
+
+protected:
+	struct Queue
+	{
+		int64_t times[MaxPending];
+		uint32_t count = 0;
+	};
+
+	Queue pending[(int)InputClass::Count];
+	FrameTimeHistogram histograms[(int)InputClass::Count];
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "WindowPlatform.h"
+
+// Focus and client area of the game window, updated from the window messages that change them,
+// so mouse messages can be filtered using just their own coordinates instead of querying the system each time.
+class WindowInputState
+{
+public:
+	// WM_ACTIVATE, WM_SETFOCUS, WM_KILLFOCUS
+	void SetFocus(bool focused)
+	{
+		this->focused = focused;
+	}
+
+	bool HasFocus() const
+	{
+		return focused;
+	}
+
+	// client area in screen coordinates, on WM_WINDOWPOSCHANGED
+	void SetClientRect(const PlatformRect& rect)
+	{
+		clientRect = rect;
+	}
+
+	// position in client coordinates (mouse move and button messages)
+	bool IsInClient(PlatformPoint pos) const
+	{
+		return pos.x >= 0 && pos.y >= 0 &&
+			pos.x < clientRect.right - clientRect.left &&
+			pos.y < clientRect.bottom - clientRect.top;
+	}
+
+	// position in screen coordinates (mouse wheel messages)
+	bool IsInClientScreen(PlatformPoint pos) const
+	{
+		return pos.x >= clientRect.left && pos.y >= clientRect.top &&
+			pos.x < clientRect.right && pos.y < clientRect.bottom;
+	}
+
+protected:
+	bool focused = false;
+	PlatformRect clientRect = {};
+};
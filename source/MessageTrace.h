@@ -0,0 +1,167 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "WindowPlatform.h"
+
+// running totals of work done by the window code, sampled around each message
+struct MessageWork
+{
+	uint32_t geometry; // window geometry recalculations
+	uint32_t resets; // D3D device resets
+	uint32_t platformCalls; // calls through WindowPlatform. Not included: DefWindowProc, key state, cursor and raw input reads,
+	                        // the Alt+Tab minimize and whatever the game's own window procedure does once forwarded to
+};
+
+// single window message, 32 bytes in the file
+struct MessageRecord
+{
+	int64_t time; // ns, handler entry
+	uint32_t duration; // ns spent in the handler including nested messages
+	uint32_t message;
+	uint32_t wParam;
+	uint32_t lParam;
+	int32_t result;
+	uint8_t depth; // nesting level, messages sent from within another handler are above 0
+	uint8_t geometry; // work done while handling, saturated at 255
+	uint8_t resets;
+	uint8_t platformCalls;
+};
+static_assert(sizeof(MessageRecord) == 32, "MessageRecord is part of the file format");
+
+// Ring of the most recent window messages passing through the window procedure.
+// Saved as compact binary file so exact message orderings of resize, drag or Alt+Tab can be inspected and replayed.
+class MessageTrace
+{
+public:
+	static constexpr uint32_t Capacity = 8192; // power of 2
+	static constexpr uint32_t MaxDepth = 64; // deeper nested messages are recorded without work counters
+
+	// Parameters pointing to structures are recorded by value, as far as the window code uses them:
+	// WM_WINDOWPOSCHANGED position in wParam, size and SWP_NOSIZE/SWP_NOMOVE in lParam,
+	// WM_SIZING window size in lParam, WM_DPICHANGED suggested position in lParam.
+	static uint32_t PackPoint(PlatformPoint point)
+	{
+		return uint32_t(uint16_t(point.x)) | uint32_t(uint16_t(point.y)) << 16;
+	}
+
+	static PlatformPoint UnpackPoint(uint32_t value)
+	{
+		return { int16_t(value & 0xFFFF), int16_t(value >> 16) };
+	}
+
+	static uint32_t PackSize(PlatformPoint size, uint32_t flags) // flags are SWP_NOSIZE and SWP_NOMOVE
+	{
+		return (uint32_t(size.x) & 0x7FFF) | (uint32_t(size.y) & 0x7FFF) << 15 | (flags & 3) << 30;
+	}
+
+	static PlatformPoint UnpackSize(uint32_t value, uint32_t& flags)
+	{
+		flags = value >> 30;
+		return { int32_t(value & 0x7FFF), int32_t(value >> 15 & 0x7FFF) };
+	}
+
+	// returns ticket for End()
+	uint32_t Begin(uint32_t message, uint32_t wParam, uint32_t lParam, int64_t now, const MessageWork& work)
+	{
+		auto& record = records[count & (Capacity - 1)];
+		record = {};
+		record.time = now;
+		record.message = message;
+		record.wParam = wParam;
+		record.lParam = lParam;
+		record.depth = depth < UINT8_MAX ? uint8_t(depth) : UINT8_MAX;
+
+		if (depth < MaxDepth) startWork[depth] = work; // handlers always finish in reverse order
+		depth++;
+		return count++;
+	}
+
+	void End(uint32_t ticket, int32_t result, int64_t now, const MessageWork& work)
+	{
+		depth--;
+		if (count - ticket > Capacity) return; // already overwritten
+
+		auto& record = records[ticket & (Capacity - 1)];
+		auto duration = now - record.time;
+		record.duration = duration < UINT32_MAX ? uint32_t(duration) : UINT32_MAX;
+		record.result = result;
+
+		if (depth < MaxDepth)
+		{
+			auto& start = startWork[depth];
+			record.geometry = Saturate(work.geometry - start.geometry);
+			record.resets = Saturate(work.resets - start.resets);
+			record.platformCalls = Saturate(work.platformCalls - start.platformCalls);
+		}
+	}
+
+	uint32_t GetCount() const
+	{
+		return count < Capacity ? count : Capacity;
+	}
+
+	// oldest record has index 0
+	const MessageRecord& Get(uint32_t index) const
+	{
+		return records[(count - GetCount() + index) & (Capacity - 1)];
+	}
+
+	void Clear()
+	{
+		count = 0;
+	}
+
+	bool Save(FILE* file) const
+	{
+		FileHeader header = { FileMagic, sizeof(MessageRecord), GetCount() };
+		if (fwrite(&header, sizeof(header), 1, file) != 1)
+			return false;
+
+		for (uint32_t i = 0; i < header.count; i++)
+		{
+			if (fwrite(&Get(i), sizeof(MessageRecord), 1, file) != 1)
+				return false;
+		}
+		return true;
+	}
+
+	// replaces current content, returns false if file is not a message trace
+	bool Load(FILE* file)
+	{
+		count = 0;
+		depth = 0;
+
+		FileHeader header = {};
+		if (fread(&header, sizeof(header), 1, file) != 1 ||
+			header.magic != FileMagic ||
+			header.recordSize != sizeof(MessageRecord) ||
+			header.count > Capacity)
+			return false;
+
+		if (fread(records, sizeof(MessageRecord), header.count, file) != header.count)
+			return false;
+
+		count = header.count;
+		return true;
+	}
+
+protected:
+	static constexpr uint32_t FileMagic = 0x31524D57; // "WMR1"
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t recordSize;
+		uint32_t count;
+	};
+
+	MessageRecord records[Capacity];
+	uint32_t count = 0;
+	uint32_t depth = 0;
+	MessageWork startWork[MaxDepth];
+
+	static uint8_t Saturate(uint32_t value)
+	{
+		return value < UINT8_MAX ? uint8_t(value) : UINT8_MAX;
+	}
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+#include "WindowPlatform.h"
+
+// Snapshot of all connected monitors, rebuilt only when the display configuration changes.
+// Empty monitor list (reported for a moment while displays change) keeps the previous snapshot until a query succeeds.
+// Monitor containing a point is found by binary search: monitors are split into vertical slabs
+// between their distinct left/right edges, each slab keeps its monitors sorted from top to bottom.
+class MonitorTopology
+{
+public:
+	uint32_t rebuilds = 0; // statistics
+
+	MonitorTopology(WindowPlatform& platform) : platform(platform)
+	{
+	}
+
+	size_t GetCount()
+	{
+		Update();
+		return monitors.size();
+	}
+
+	const MonitorInfo& Get(size_t index)
+	{
+		Update();
+		return monitors[index];
+	}
+
+	// monitor containing the point, nearest one if it lies outside of all monitors, empty rect if none was ever reported
+	const MonitorInfo& Find(PlatformPoint pos)
+	{
+		Update();
+		if (monitors.empty())
+			return none;
+
+		auto slab = std::upper_bound(edges.begin(), edges.end(), pos.x) - edges.begin() - 1; // last edge <= x
+		if (slab >= 0 && slab < (ptrdiff_t)slabs.size())
+		{
+			auto& column = slabs[slab];
+			auto it = std::upper_bound(column.begin(), column.end(), pos.y,
+				[&](int32_t y, uint32_t index) { return y < monitors[index].rect.top; }); // first starting below y
+
+			if (it != column.begin() && pos.y < monitors[*(it - 1)].rect.bottom)
+				return monitors[*(it - 1)];
+		}
+
+		return FindNearest(pos); // off screen, rare
+	}
+
+	// WM_DISPLAYCHANGE, WM_DPICHANGED, work area change
+	void Invalidate()
+	{
+		valid = false;
+	}
+
+protected:
+	WindowPlatform& platform;
+	bool valid = false;
+	std::vector<MonitorInfo> monitors;
+	std::vector<MonitorInfo> queried;
+	std::vector<int32_t> edges; // sorted distinct x coordinates of monitor sides
+	std::vector<std::vector<uint32_t>> slabs; // monitors covering [edges[i], edges[i + 1]), sorted by top
+	MonitorInfo none = {};
+
+	void Update()
+	{
+		if (valid) return;
+
+		queried.clear();
+		platform.GetMonitors(queried);
+		if (queried.empty())
+			return; // stays invalid, asked again by the next lookup
+
+		valid = true;
+		rebuilds++;
+		monitors.swap(queried);
+
+		edges.clear();
+		for (auto& monitor : monitors)
+		{
+			edges.push_back(monitor.rect.left);
+			edges.push_back(monitor.rect.right);
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		slabs.assign(edges.empty() ? 0 : edges.size() - 1, {});
+		for (size_t i = 0; i < slabs.size(); i++)
+		{
+			for (uint32_t index = 0; index < monitors.size(); index++)
+			{
+				auto& rect = monitors[index].rect;
+				if (rect.left <= edges[i] && edges[i] < rect.right)
+					slabs[i].push_back(index);
+			}
+
+			std::sort(slabs[i].begin(), slabs[i].end(),
+				[&](uint32_t a, uint32_t b) { return monitors[a].rect.top < monitors[b].rect.top; });
+		}
+	}
+
+	const MonitorInfo& FindNearest(PlatformPoint pos) const
+	{
+		auto distance = [&](const PlatformRect& rect)
+		{
+			int64_t dx = pos.x < rect.left ? rect.left - pos.x : pos.x >= rect.right ? pos.x - rect.right + 1 : 0;
+			int64_t dy = pos.y < rect.top ? rect.top - pos.y : pos.y >= rect.bottom ? pos.y - rect.bottom + 1 : 0;
+			return dx * dx + dy * dy;
+		};
+
+		size_t nearest = 0;
+		for (size_t i = 1; i < monitors.size(); i++)
+		{
+			if (distance(monitors[i].rect) < distance(monitors[nearest].rect))
+				nearest = i;
+		}
+		return monitors[nearest];
+	}
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Sums relative mouse movement of any number of input events until the consumer takes it, once per frame.
+// Both axes are packed into single 64 bit value, so each event costs one atomic add and the pair is always consistent.
+class MouseAccumulator
+{
+public:
+	struct Delta
+	{
+		int32_t x, y;
+		int32_t wheel;
+		uint32_t events; // added into this delta, 0 if the producer was silent
+	};
+
+	// producer side, any thread
+	void Add(int32_t x, int32_t y, int32_t wheel = 0)
+	{
+		motion.fetch_add(Pack(x, y), std::memory_order_relaxed);
+		if (wheel) this->wheel.fetch_add(wheel, std::memory_order_relaxed);
+		events.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// consumer side, returns everything collected since previous call
+	Delta Sample()
+	{
+		auto packed = motion.exchange(0, std::memory_order_relaxed);
+		auto x = int32_t(uint32_t(packed));
+		auto y = int32_t(uint32_t((packed - uint64_t(int64_t(x))) >> 32));
+		return { x, y, wheel.exchange(0, std::memory_order_relaxed), events.exchange(0, std::memory_order_relaxed) };
+	}
+
+protected:
+	std::atomic<uint64_t> motion = 0; // x + y * 2^32, wrapping
+	std::atomic<int32_t> wheel = 0;
+	std::atomic<uint32_t> events = 0;
+
+	static uint64_t Pack(int32_t x, int32_t y)
+	{
+		return uint64_t(int64_t(x)) + (uint64_t(uint32_t(y)) << 32);
+	}
+};
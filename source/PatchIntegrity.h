@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <array>
+
+// lookup tables for slice-by-8 CRC-32
+static constexpr std::array<std::array<uint32_t, 256>, 8> BuildCrc32Tables()
+{
+	std::array<std::array<uint32_t, 256>, 8> tables = {};
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t crc = i;
+		for (int j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		tables[0][i] = crc;
+	}
+
+	for (uint32_t i = 0; i < 256; i++)
+		for (int slice = 1; slice < 8; slice++)
+			tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+
+	return tables;
+}
+
+// CRC-32 (IEEE, reflected polynomial 0xEDB88320) computed 8 bytes at a time with slice-by-8 tables.
+// Produces the same values as the classic bit by bit implementation.
+class Crc32
+{
+public:
+	static uint32_t Compute(const void* data, size_t size, uint32_t crc = 0)
+	{
+		auto bytes = (const uint8_t*)data;
+		crc = ~crc;
+
+		while (size >= 8)
+		{
+			uint32_t one, two;
+			memcpy(&one, bytes, 4); // little endian
+			memcpy(&two, bytes + 4, 4);
+			one ^= crc;
+
+			crc = Tables[7][one & 0xFF] ^ Tables[6][(one >> 8) & 0xFF] ^ Tables[5][(one >> 16) & 0xFF] ^ Tables[4][one >> 24] ^
+				Tables[3][two & 0xFF] ^ Tables[2][(two >> 8) & 0xFF] ^ Tables[1][(two >> 16) & 0xFF] ^ Tables[0][two >> 24];
+
+			bytes += 8;
+			size -= 8;
+		}
+
+		while (size--)
+			crc = (crc >> 8) ^ Tables[0][(crc ^ *bytes++) & 0xFF];
+
+		return ~crc;
+	}
+
+protected:
+	static constexpr auto Tables = BuildCrc32Tables();
+};
+
+// memory area about to be patched, with hash of its original content
+struct PatchSite
+{
+	const char* name;
+	uintptr_t address;
+	uint32_t size;
+	uint32_t hash;
+};
+
+// Hashes every site in place (no copies) in a single pass.
+// Calls onMismatch(site, actualHash) for modified ones, returns their count.
+template <class Callback>
+static size_t VerifyPatchSites(const PatchSite* sites, size_t count, Callback&& onMismatch)
+{
+	size_t mismatches = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		auto hash = Crc32::Compute((const void*)sites[i].address, sites[i].size);
+		if (hash != sites[i].hash)
+		{
+			onMismatch(sites[i], hash);
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
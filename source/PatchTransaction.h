@@ -0,0 +1,246 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// access to the memory being patched, implemented by the platform (or simulated)
+class PatchMemory
+{
+public:
+	static constexpr uintptr_t PageSize = 0x1000;
+
+	virtual ~PatchMemory() = default;
+
+	virtual bool Unprotect(uintptr_t page, uint32_t& oldProtection) = 0; // make single page writable
+	virtual void Protect(uintptr_t page, uint32_t protection) = 0;
+	virtual void FlushCode(uintptr_t address, size_t size) = 0;
+	virtual void Read(uintptr_t address, void* data, size_t size) = 0;
+	virtual void Write(uintptr_t address, const void* data, size_t size) = 0;
+};
+
+// single modification of memory
+struct PatchOp
+{
+	enum Type : uint8_t
+	{
+		Bytes, // up to 8 bytes of data
+		Nop,
+		Call, // rel32 call, rest of the size filled with NOPs
+		Jump, // rel32 jump, rest of the size filled with NOPs
+		Custom, // callback modifying the area while it is writable
+	};
+
+	Type type;
+	uint32_t size; // bytes affected
+	uintptr_t address;
+	uintptr_t target = 0; // Call, Jump
+	uint8_t data[8] = {}; // Bytes
+	void (*apply)(uintptr_t address) = nullptr; // Custom
+
+	template <class T>
+	static PatchOp Write(uintptr_t address, T value)
+	{
+		static_assert(sizeof(T) <= sizeof(data), "Value too big");
+		PatchOp op = { Bytes, sizeof(T), address };
+		memcpy(op.data, &value, sizeof(T));
+		return op;
+	}
+
+	static PatchOp MakeNOP(uintptr_t address, uint32_t size)
+	{
+		return { Nop, size, address };
+	}
+
+	template <class T>
+	static PatchOp MakeCALL(uintptr_t address, T* function, uint32_t size = 5)
+	{
+		return { Call, size, address, (uintptr_t)function };
+	}
+
+	template <class T>
+	static PatchOp MakeJMP(uintptr_t address, T* function, uint32_t size = 5)
+	{
+		return { Jump, size, address, (uintptr_t)function };
+	}
+
+	static PatchOp MakeJMP(uintptr_t address, uintptr_t target, uint32_t size = 5)
+	{
+		return { Jump, size, address, target };
+	}
+
+	static PatchOp MakeCustom(uintptr_t address, uint32_t size, void (*apply)(uintptr_t address))
+	{
+		return { Custom, size, address, 0, {}, apply };
+	}
+};
+
+// Applies set of patches as one unit. Pages touched by any of them are unprotected once each,
+// instruction cache is flushed once, and if anything fails all the memory is restored to its original state.
+class PatchTransaction
+{
+public:
+	enum Result
+	{
+		Success,
+		InvalidPatch, // bad size, missing target or patches overlap
+		ProtectFailed,
+		WriteFailed, // memory content does not match after writing
+	};
+
+	// statistics
+	uint32_t protectCalls = 0;
+
+	PatchTransaction(PatchMemory& memory) : memory(memory)
+	{
+	}
+
+	Result Apply(const PatchOp* ops, size_t count)
+	{
+		if (!Plan(ops, count))
+			return InvalidPatch;
+
+		// open all the pages
+		size_t opened = 0;
+		for (; opened < pages.size(); opened++)
+		{
+			protectCalls++;
+			if (!memory.Unprotect(pages[opened].address, pages[opened].protection))
+				break;
+		}
+
+		if (opened < pages.size())
+		{
+			Close(opened);
+			return ProtectFailed;
+		}
+
+		// backup for rollback
+		backup.resize(backupSize);
+		auto dst = backup.data();
+		for (size_t i = 0; i < count; i++)
+		{
+			memory.Read(ops[i].address, dst, ops[i].size);
+			dst += ops[i].size;
+		}
+
+		auto result = Success;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!Execute(ops[i]))
+			{
+				result = WriteFailed;
+				break;
+			}
+		}
+
+		if (result != Success)
+		{
+			auto src = backup.data();
+			for (size_t i = 0; i < count; i++)
+			{
+				memory.Write(ops[i].address, src, ops[i].size);
+				src += ops[i].size;
+			}
+		}
+
+		memory.FlushCode(rangeBegin, rangeEnd - rangeBegin);
+		Close(pages.size());
+		return result;
+	}
+
+	template <size_t Count>
+	Result Apply(const PatchOp (&ops)[Count])
+	{
+		return Apply(ops, Count);
+	}
+
+protected:
+	struct Page
+	{
+		uintptr_t address;
+		uint32_t protection; // original
+	};
+
+	PatchMemory& memory;
+	std::vector<Page> pages;
+	std::vector<uint8_t> backup;
+	std::vector<uint8_t> expected;
+	std::vector<uint8_t> written;
+	size_t backupSize = 0;
+	uintptr_t rangeBegin = 0, rangeEnd = 0;
+
+	// collects sorted list of affected pages, fails on overlapping patches
+	bool Plan(const PatchOp* ops, size_t count)
+	{
+		pages.clear();
+		backupSize = 0;
+		rangeBegin = UINTPTR_MAX;
+		rangeEnd = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			auto& op = ops[i];
+			if (!op.size || op.address + op.size < op.address ||
+				(op.type == PatchOp::Bytes && op.size > sizeof(op.data)) ||
+				((op.type == PatchOp::Call || op.type == PatchOp::Jump) && (op.size < 5 || !op.target)) ||
+				(op.type == PatchOp::Custom && !op.apply))
+				return false;
+
+			for (size_t j = 0; j < i; j++)
+			{
+				if (op.address < ops[j].address + ops[j].size && ops[j].address < op.address + op.size)
+					return false;
+			}
+
+			for (auto page = op.address & ~(PatchMemory::PageSize - 1); page < op.address + op.size; page += PatchMemory::PageSize)
+				pages.push_back({ page, 0 });
+
+			backupSize += op.size;
+			rangeBegin = (std::min)(rangeBegin, op.address); // parentheses keep windows.h min/max macros out
+			rangeEnd = (std::max)(rangeEnd, op.address + op.size);
+		}
+
+		std::sort(pages.begin(), pages.end(), [](const Page& a, const Page& b) { return a.address < b.address; });
+		pages.erase(std::unique(pages.begin(), pages.end(), [](const Page& a, const Page& b) { return a.address == b.address; }), pages.end());
+		return true;
+	}
+
+	bool Execute(const PatchOp& op)
+	{
+		if (op.type == PatchOp::Custom)
+		{
+			op.apply(op.address);
+			return true;
+		}
+
+		expected.assign(op.size, 0x90); // NOP
+		if (op.type == PatchOp::Bytes)
+		{
+			memcpy(expected.data(), op.data, op.size);
+		}
+		else if (op.type == PatchOp::Call || op.type == PatchOp::Jump)
+		{
+			auto offset = uint32_t(op.target - (op.address + 5));
+			expected[0] = op.type == PatchOp::Call ? 0xE8 : 0xE9;
+			memcpy(expected.data() + 1, &offset, sizeof(offset));
+		}
+
+		memory.Write(op.address, expected.data(), op.size);
+
+		// verify
+		written.resize(op.size);
+		memory.Read(op.address, written.data(), op.size);
+		return written == expected;
+	}
+
+	// restores protection of first count pages
+	void Close(size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			protectCalls++;
+			memory.Protect(pages[i].address, pages[i].protection);
+		}
+	}
+};
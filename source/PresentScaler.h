@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+// how back buffer of different size is scaled into the window
+enum class ScalePolicy : uint8_t
+{
+	Fill, // stretch over whole client area, ignores aspect ratio
+	AspectFit, // largest size keeping aspect ratio, black bars on the sides
+	IntegerScale, // largest whole multiple of the source size, falls back to AspectFit when downscaling
+};
+
+struct ScaleRect
+{
+	int32_t left, top, right, bottom;
+
+	int32_t Width() const { return right - left; }
+	int32_t Height() const { return bottom - top; }
+	bool operator==(const ScaleRect& other) const = default;
+};
+
+// destination rectangle of the source image inside target area of given size
+static inline ScaleRect ScaleToFit(int32_t srcWidth, int32_t srcHeight, int32_t dstWidth, int32_t dstHeight, ScalePolicy policy)
+{
+	if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 || policy == ScalePolicy::Fill)
+		return { 0, 0, dstWidth, dstHeight };
+
+	int64_t width, height;
+
+	auto scale = dstWidth / srcWidth < dstHeight / srcHeight ? dstWidth / srcWidth : dstHeight / srcHeight;
+	if (policy == ScalePolicy::IntegerScale && scale >= 1)
+	{
+		width = int64_t(srcWidth) * scale;
+		height = int64_t(srcHeight) * scale;
+	}
+	else if (int64_t(dstWidth) * srcHeight <= int64_t(dstHeight) * srcWidth) // width is the limit
+	{
+		width = dstWidth;
+		height = (int64_t(dstWidth) * srcHeight + srcWidth / 2) / srcWidth;
+	}
+	else
+	{
+		width = (int64_t(dstHeight) * srcWidth + srcHeight / 2) / srcHeight;
+		height = dstHeight;
+	}
+
+	auto left = int32_t((dstWidth - width) / 2);
+	auto top = int32_t((dstHeight - height) / 2);
+	return { left, top, left + int32_t(width), top + int32_t(height) };
+}
+
+// converts point in the target area into source image coordinates, clamped to the image
+static inline void MapToSource(const ScaleRect& dstRect, int32_t srcWidth, int32_t srcHeight, int32_t& x, int32_t& y)
+{
+	if (dstRect.Width() <= 0 || dstRect.Height() <= 0)
+		return;
+
+	x = int32_t(int64_t(x - dstRect.left) * srcWidth / dstRect.Width());
+	y = int32_t(int64_t(y - dstRect.top) * srcHeight / dstRect.Height());
+
+	x = x < 0 ? 0 : x >= srcWidth ? srcWidth - 1 : x;
+	y = y < 0 ? 0 : y >= srcHeight ? srcHeight - 1 : y;
+}
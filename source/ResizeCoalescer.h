@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+
+// Collects window size changes and releases them only once the size stopped changing for a while,
+// or the user finished dragging the window edge. Each released size costs a D3D device reset.
+// Time is passed in by the caller (ns) so any clock can drive it.
+class ResizeCoalescer
+{
+public:
+	struct Size
+	{
+		int32_t width, height;
+
+		bool operator==(const Size& other) const = default;
+	};
+
+	int64_t settleTime = 150000000; // ns the size has to stay unchanged
+
+	// statistics
+	uint32_t requests = 0;
+	uint32_t commits = 0;
+
+	// size of the back buffer currently in use, drops anything pending
+	void SetApplied(Size size)
+	{
+		applied = size;
+		pending = false;
+	}
+
+	Size GetApplied() const
+	{
+		return applied;
+	}
+
+	// new client area size observed
+	void Resize(Size size, int64_t now)
+	{
+		requests++;
+
+		if (size == applied)
+		{
+			pending = false; // back where we started, nothing to do
+			return;
+		}
+
+		target = size;
+		lastChange = now;
+		pending = true;
+	}
+
+	// WM_EXITSIZEMOVE, pending size is released on next poll without waiting
+	void EndDrag(int64_t now)
+	{
+		lastChange = now - settleTime;
+	}
+
+	bool IsPending() const
+	{
+		return pending;
+	}
+
+	Size GetPending() const
+	{
+		return target;
+	}
+
+	// returns true once the pending size settled, caller marks it applied after the game got told about it
+	bool Poll(int64_t now, Size& size)
+	{
+		if (!pending || now - lastChange < settleTime)
+			return false;
+
+		size = target;
+		pending = false;
+		commits++;
+		return true;
+	}
+
+protected:
+	Size applied = {};
+	Size target = {};
+	int64_t lastChange = 0;
+	bool pending = false;
+};
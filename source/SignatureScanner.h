@@ -0,0 +1,326 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "PatchIntegrity.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIGNATURE_SCANNER_SSE2
+#endif
+
+// Byte signature with wildcards, parsed from text like "8B 0D ?? ?? ?? ?? 85 C9".
+class BytePattern
+{
+public:
+	static constexpr size_t MaxLength = 64;
+
+	BytePattern(const char* text)
+	{
+		while (*text)
+		{
+			if (*text == ' ')
+			{
+				text++;
+				continue;
+			}
+
+			if (length >= MaxLength)
+			{
+				length = 0; // too long
+				return;
+			}
+
+			if (text[0] == '?')
+			{
+				text += text[1] == '?' ? 2 : 1;
+				bytes[length] = 0;
+				mask[length++] = false;
+				continue;
+			}
+
+			auto high = HexValue(text[0]);
+			auto low = high < 0 ? -1 : HexValue(text[1]);
+			if (low < 0)
+			{
+				length = 0; // malformed
+				return;
+			}
+
+			text += 2;
+			bytes[length] = uint8_t(high << 4 | low);
+			mask[length++] = true;
+		}
+
+		// anchors used to filter candidates, wildcards can not be anchors
+		first = last = length;
+		for (size_t i = 0; i < length; i++)
+		{
+			if (!mask[i]) continue;
+			if (first == length) first = i;
+			last = i;
+		}
+
+		if (first == length) length = 0; // wildcards only
+	}
+
+	bool IsValid() const
+	{
+		return length != 0;
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	bool Matches(const uint8_t* data) const
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			if (mask[i] && data[i] != bytes[i]) return false;
+		}
+		return true;
+	}
+
+	// first occurrence in range, nullptr if none
+	const uint8_t* Find(const uint8_t* begin, const uint8_t* end) const
+	{
+		if (!length || size_t(end - begin) < length)
+			return nullptr;
+
+		auto lastStart = end - length; // last position where whole pattern still fits
+		auto pos = begin;
+
+#ifdef SIGNATURE_SCANNER_SSE2
+		// test 16 positions at once, only those having both anchor bytes in place get fully compared
+		auto firstByte = _mm_set1_epi8((char)bytes[first]);
+		auto lastByte = _mm_set1_epi8((char)bytes[last]);
+
+		for (; lastStart - pos >= 15; pos += 16)
+		{
+			auto a = _mm_loadu_si128((const __m128i*)(pos + first));
+			auto b = _mm_loadu_si128((const __m128i*)(pos + last));
+			auto candidates = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firstByte), _mm_cmpeq_epi8(b, lastByte)));
+
+			while (candidates)
+			{
+				auto offset = CountTrailingZeros(candidates);
+				if (Matches(pos + offset)) return pos + offset;
+				candidates &= candidates - 1;
+			}
+		}
+#endif
+
+		for (; pos <= lastStart; pos++)
+		{
+			if (pos[first] == bytes[first] && pos[last] == bytes[last] && Matches(pos)) return pos;
+		}
+
+		return nullptr;
+	}
+
+protected:
+	uint8_t bytes[MaxLength] = {};
+	bool mask[MaxLength] = {}; // false for wildcards
+	size_t length = 0;
+	size_t first = 0, last = 0;
+
+	static int HexValue(char c)
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		return -1;
+	}
+
+	static uint32_t CountTrailingZeros(uint32_t value)
+	{
+		uint32_t count = 0;
+		while (!(value & 1))
+		{
+			value >>= 1;
+			count++;
+		}
+		return count;
+	}
+};
+
+// Minimal reader of loaded (mapped) PE image headers, works on any platform.
+class PeImage
+{
+public:
+	PeImage(const uint8_t* base) : base(base)
+	{
+		if (Read16(0) != 0x5A4D) return; // MZ
+		auto header = Read32(0x3C);
+		if (Read32(header) != 0x00004550) return; // PE\0\0
+
+		sectionCount = Read16(header + 6);
+		auto optionalSize = Read16(header + 20);
+		imageSize = Read32(header + 24 + 56);
+		sections = header + 24 + optionalSize;
+		valid = true;
+	}
+
+	bool IsValid() const
+	{
+		return valid;
+	}
+
+	// finds section by name, e.g. ".text"
+	bool GetSection(const char* name, const uint8_t*& begin, const uint8_t*& end) const
+	{
+		for (uint32_t i = 0; valid && i < sectionCount; i++)
+		{
+			auto section = sections + i * 40;
+			if (strncmp((const char*)base + section, name, 8)) continue;
+
+			begin = base + Read32(section + 12); // VirtualAddress
+			end = begin + Read32(section + 8); // VirtualSize
+			return true;
+		}
+		return false;
+	}
+
+	// identifies exact executable build without hashing the whole file
+	uint32_t GetHash() const
+	{
+		if (!valid) return 0;
+		auto hash = Crc32::Compute(base, sections + sectionCount * 40); // all headers
+		return Crc32::Compute(&imageSize, sizeof(imageSize), hash);
+	}
+
+	const uint8_t* GetBase() const
+	{
+		return base;
+	}
+
+protected:
+	const uint8_t* base;
+	bool valid = false;
+	uint32_t sectionCount = 0;
+	uint32_t imageSize = 0;
+	uint32_t sections = 0; // offset of section table
+
+	uint16_t Read16(uint32_t offset) const
+	{
+		uint16_t value;
+		memcpy(&value, base + offset, sizeof(value));
+		return value;
+	}
+
+	uint32_t Read32(uint32_t offset) const
+	{
+		uint32_t value;
+		memcpy(&value, base + offset, sizeof(value));
+		return value;
+	}
+};
+
+// Finds addresses by signature in code section of the image.
+// Results are stored as image offsets in small cache file, valid only for the exact same executable,
+// so following launches do not need to scan at all.
+class SignatureResolver
+{
+public:
+	static constexpr size_t MaxEntries = 128;
+
+	// statistics
+	uint32_t scans = 0;
+	uint32_t cacheHits = 0;
+
+	SignatureResolver(const uint8_t* imageBase) : image(imageBase)
+	{
+		image.GetSection(".text", textBegin, textEnd);
+		imageHash = image.GetHash();
+	}
+
+	// Address of the signature match plus offset, 0 if not found.
+	// Cache entry is keyed by name, pattern and offset, so a changed signature is scanned for again
+	uintptr_t Resolve(const char* name, const char* pattern, int32_t offset = 0)
+	{
+		auto key = Crc32::Compute(name, strlen(name));
+		key = Crc32::Compute(pattern, strlen(pattern), key);
+		key = Crc32::Compute(&offset, sizeof(offset), key);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (entries[i].key == key)
+			{
+				cacheHits++;
+				return entries[i].offset ? uintptr_t(image.GetBase() + entries[i].offset) : 0;
+			}
+		}
+
+		scans++;
+		uintptr_t address = 0;
+		BytePattern signature(pattern);
+		auto match = textBegin ? signature.Find(textBegin, textEnd) : nullptr;
+		if (match) address = uintptr_t(match + offset);
+
+		if (count < MaxEntries)
+		{
+			entries[count++] = { key, address ? uint32_t(address - uintptr_t(image.GetBase())) : 0 }; // misses are cached too
+			modified = true;
+		}
+
+		return address;
+	}
+
+	// returns false if cache file belongs to another executable or is damaged
+	bool LoadCache(FILE* file)
+	{
+		CacheHeader header = {};
+		bool loaded = fread(&header, sizeof(header), 1, file) == 1 &&
+			header.magic == CacheMagic &&
+			header.imageHash == imageHash &&
+			header.count <= MaxEntries &&
+			fread(entries, sizeof(CacheEntry), header.count, file) == header.count;
+
+		count = loaded ? header.count : 0;
+		modified = false;
+		return loaded;
+	}
+
+	// true if something new was resolved since load
+	bool IsCacheModified() const
+	{
+		return modified;
+	}
+
+	bool SaveCache(FILE* file)
+	{
+		CacheHeader header = { CacheMagic, imageHash, (uint32_t)count };
+		bool saved = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(entries, sizeof(CacheEntry), count, file) == count;
+
+		modified = !saved;
+		return saved;
+	}
+
+protected:
+	static constexpr uint32_t CacheMagic = 0x31434157; // "WAC1"
+
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t imageHash;
+		uint32_t count;
+	};
+
+	struct CacheEntry
+	{
+		uint32_t key; // hash of name, pattern and offset
+		uint32_t offset; // from image base, 0 if not found
+	};
+
+	PeImage image;
+	const uint8_t* textBegin = nullptr;
+	const uint8_t* textEnd = nullptr;
+	uint32_t imageHash = 0;
+
+	CacheEntry entries[MaxEntries];
+	size_t count = 0;
+	bool modified = false;
+};
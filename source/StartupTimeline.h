@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Named time spans (ns) recorded during startup. Fixed storage, so it is safe to use from DllMain.
+class StartupTimeline
+{
+public:
+	static constexpr size_t MaxSpans = 32;
+
+	struct Span
+	{
+		const char* name;
+		int64_t begin;
+		int64_t end; // same as begin until finished
+		bool instant; // single event instead of span
+	};
+
+	// returns span index for End()
+	size_t Begin(const char* name, int64_t now)
+	{
+		if (count >= MaxSpans)
+			return MaxSpans;
+
+		spans[count] = { name, now, now, false };
+		return count++;
+	}
+
+	// single event without duration
+	void Mark(const char* name, int64_t now)
+	{
+		if (count < MaxSpans)
+			spans[count++] = { name, now, now, true };
+	}
+
+	void End(size_t index, int64_t now)
+	{
+		if (index < count)
+			spans[index].end = now;
+	}
+
+	size_t GetCount() const
+	{
+		return count;
+	}
+
+	const Span& Get(size_t index) const
+	{
+		return spans[index];
+	}
+
+	// time of the first recorded event
+	int64_t GetOrigin() const
+	{
+		return count ? spans[0].begin : 0;
+	}
+
+	// Chrome trace event format, open in chrome://tracing or ui.perfetto.dev
+	void WriteJson(FILE* file) const
+	{
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+		auto origin = GetOrigin();
+		for (size_t i = 0; i < count; i++)
+		{
+			auto& span = spans[i];
+			if (span.instant)
+				fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+					i ? ",\n" : "", span.name, (span.begin - origin) / 1000.0);
+			else
+				fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+					i ? ",\n" : "", span.name, (span.begin - origin) / 1000.0, (span.end - span.begin) / 1000.0);
+		}
+
+		fputs("\n]}\n", file);
+	}
+
+protected:
+	Span spans[MaxSpans] = {};
+	size_t count = 0;
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <charconv>
+#include <thread>
+
+// Fixed size text builder, never allocates. Output is truncated when full.
+class TitleText
+{
+public:
+	static constexpr size_t Capacity = 160;
+
+	void Clear()
+	{
+		length = 0;
+		text[0] = '\0';
+	}
+
+	TitleText& Append(const char* str)
+	{
+		auto count = strlen(str);
+		if (count > Capacity - 1 - length) count = Capacity - 1 - length;
+		memcpy(text + length, str, count);
+		length += count;
+		text[length] = '\0';
+		return *this;
+	}
+
+	TitleText& Append(char c)
+	{
+		const char str[] = { c, '\0' };
+		return Append(str);
+	}
+
+	TitleText& Append(uint32_t value)
+	{
+		auto result = std::to_chars(text + length, text + Capacity - 1, value);
+		if (result.ec == std::errc())
+			length = result.ptr - text;
+		text[length] = '\0';
+		return *this;
+	}
+
+	// nanoseconds as milliseconds with one decimal place
+	TitleText& AppendMs(int64_t ns)
+	{
+		auto tenths = uint32_t((ns < 0 ? 0 : ns + 50000) / 100000);
+		return Append(tenths / 10).Append('.').Append(tenths % 10);
+	}
+
+	const char* c_str() const
+	{
+		return text;
+	}
+
+	size_t size() const
+	{
+		return length;
+	}
+
+	bool operator==(const TitleText& other) const
+	{
+		return length == other.length && !memcmp(text, other.text, length);
+	}
+
+protected:
+	char text[Capacity] = {};
+	size_t length = 0;
+};
+
+// Hands title texts over to a helper thread which applies them, so the caller never waits for the window manager.
+// Identical consecutive texts are dropped, and if the helper is busy only the latest text gets applied.
+// Posting is lock-free (triple buffer exchange), the helper thread is started on first post.
+class TitleUpdater
+{
+public:
+	using ApplyFunc = void (*)(void* context, const char* text);
+	using StartFunc = void (*)(std::thread& thread); // chance to adjust the helper thread, e.g. priority
+
+	TitleUpdater(ApplyFunc apply, void* context, StartFunc start = nullptr) : apply(apply), context(context), start(start)
+	{
+	}
+
+	// producer side, single thread only. Returns false if the text was the same as last time
+	bool Post(const TitleText& text)
+	{
+		if (posted && text == last)
+			return false;
+
+		last = text;
+		posted = true;
+
+		buffers[back] = text;
+		back = middle.exchange(back | Dirty, std::memory_order_acq_rel) & IndexMask;
+
+		if (!started)
+		{
+			std::thread thread(&TitleUpdater::Run, this);
+			if (start) start(thread);
+			thread.detach(); // lives as long as the process
+			started = true;
+		}
+
+		signal.fetch_add(1, std::memory_order_release);
+		signal.notify_one();
+		return true;
+	}
+
+protected:
+	static constexpr uint8_t Dirty = 0x4;
+	static constexpr uint8_t IndexMask = 0x3;
+
+	ApplyFunc apply;
+	void* context;
+	StartFunc start;
+
+	TitleText buffers[3];
+	uint8_t back = 0; // producer
+	std::atomic<uint8_t> middle = 1;
+	uint8_t front = 2; // helper thread
+
+	TitleText last;
+	bool posted = false;
+
+	std::atomic<uint32_t> signal = 0;
+	bool started = false;
+
+	void Run()
+	{
+		uint32_t seen = 0;
+		while (true)
+		{
+			signal.wait(seen, std::memory_order_acquire);
+			seen = signal.load(std::memory_order_acquire);
+
+			if (middle.load(std::memory_order_acquire) & Dirty)
+			{
+				front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+				apply(context, buffers[front].c_str());
+			}
+		}
+	}
+};
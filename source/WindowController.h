@@ -0,0 +1,676 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include "WindowPlatform.h"
+#include "GeometryCache.h"
+#include "MonitorTopology.h"
+#include "InputState.h"
+#include "ResizeCoalescer.h"
+#include "PresentScaler.h"
+#include "CommandQueue.h"
+#include "MessageTrace.h"
+
+// Platform independent part of the game window handling: window and back buffer geometry, coalesced resizes
+// and the commands changing them. WindowedMode feeds it from its window procedure and game hooks,
+// the tests drive it against a simulated platform.
+// Geometry is owned by the window thread, other threads only push commands and read the published present rect.
+class WindowController
+{
+public:
+	static constexpr PlatformPoint Resolution_Default = { 640, 448 }; // default GTA's PS2 resolution
+	static constexpr PlatformPoint Resolution_Min = { Resolution_Default.x / 4, Resolution_Default.y / 4 };
+
+	// window message values used here, same as Win32
+	static constexpr uint32_t NoSize = 0x0001, NoMove = 0x0002; // SWP_NOSIZE, SWP_NOMOVE
+	static constexpr uint32_t SizeMessage = 0x0005; // WM_SIZE
+	enum SizeType : uint32_t { SizeRestored, SizeMinimized, SizeMaximized, SizeMaxShow, SizeMaxHide }; // WM_SIZE wParam
+	enum SizingEdge : uint32_t { EdgeLeft = 1, EdgeRight, EdgeTop, EdgeTopLeft, EdgeTopRight, EdgeBottom, EdgeBottomLeft, EdgeBottomRight }; // WMSZ_*
+
+	// list of popular display aspect ratios
+	struct AspectRatioInfo { const char* name; float ratio; };
+	static constexpr AspectRatioInfo AspectRatios[] = {
+		{ "1:1", 1.0f / 1.0f },
+		{ "2:1", 2.0f / 1.0f },
+		{ "4:3", 4.0f / 3.0f },
+		{ "5:4", 5.0f / 4.0f },
+		{ "10:7", 10.0f / 7.0f }, // GTA default aspect
+		{ "16:9", 16.0f / 9.0f },
+		{ "16:10", 16.0f / 10.0f }
+	};
+
+	static int FindAspectRatio(PlatformPoint resolution, float treshold = 0.007f)
+	{
+		auto ratio = float(resolution.x) / resolution.y;
+
+		// find best match in
+		int idx = -1;
+		float dist = 9999.0f;
+		for (size_t i = 0; i < sizeof(AspectRatios) / sizeof(AspectRatios[0]); i++)
+		{
+			auto diff = fabsf(AspectRatios[i].ratio - ratio);
+			if (diff < dist)
+			{
+				idx = (int)i;
+				dist = diff;
+			}
+		}
+
+		return dist <= treshold ? idx : -1;
+	}
+
+	enum WindowMode : uint8_t
+	{
+		Windowed = 1, WindowedBorderless, Fullscreen,
+		Min = Windowed,
+		Max = Fullscreen
+	};
+
+	WindowPlatform& platform; // all window changes and display queries go through here
+	GeometrySource& geometrySource;
+	mutable GeometryCache geometryCache{ geometrySource }; // frame sizes, invalidated on style/DPI/display changes
+	MonitorTopology monitors{ platform }; // rebuilt on display configuration changes
+	WindowInputState inputState; // focus and client area as seen by the window messages
+
+	WindowController(WindowPlatform& platform, GeometrySource& geometrySource) : platform(platform), geometrySource(geometrySource)
+	{
+	}
+
+	virtual ~WindowController() = default;
+
+	// game window
+	std::atomic<bool> windowUpdating = false; // update in progress
+	WindowMode windowMode = WindowMode::Windowed;
+	// current window geometry
+	PlatformPoint windowPos = {};
+	PlatformPoint windowSize = {};
+	PlatformPoint windowSizeClient = {};
+	// last properties of windowed mode
+	PlatformPoint windowPosWindowed = { -1, -1 };
+	PlatformPoint windowSizeWindowed = Resolution_Default;
+	std::atomic<uint32_t> refreshRate = 0; // of the monitor showing the window, 0 if unknown
+
+	virtual uint32_t WindowStyle() const = 0;
+	virtual uint32_t WindowStyleEx() const = 0;
+	virtual void WindowUpdateTitle([[maybe_unused]] const PlatformPoint* clientSize = nullptr) {} // current client size if not specified
+	virtual void ApplyBackBuffer() {} // back buffer size decided, hand it over to the game
+	virtual void StartupMark([[maybe_unused]] const char* name) {}
+	virtual void SaveConfig() {}
+
+	// back buffer
+	bool fixedBackBuffer = false; // render at fixed resolution and scale it into the window, so resizing needs no device reset
+	PlatformPoint fixedBackBufferSize = {}; // zero for monitor's native resolution
+	ScalePolicy fixedBackBufferScaling = ScalePolicy::AspectFit;
+	static constexpr float RenderScale_Min = 0.5f;
+	static constexpr float RenderScale_Max = 2.0f;
+	float renderScale = 1.0f; // back buffer size relative to the client area, when not using fixed back buffer
+	PlatformPoint monitorSize = {};
+	PlatformPoint backBufferSize = {}; // current
+	std::atomic<uint64_t> presentRect = 0; // PresentRect() packed for the render thread, 0 if not scaled
+
+	ResizeCoalescer resizeCoalescer; // delays device resets until the window size settles
+	static constexpr uintptr_t ResizeTimer = 0x57D0; // polls the coalesced size while one is pending
+
+	// window changes requested by messages and game patches, applied on the window thread
+	struct WindowCommand
+	{
+		enum Type : uint8_t { Moved, EndDrag, Recalculate, Resize, DeviceReset } type = Moved;
+		uint32_t flags = 0; // Moved: NoMove/NoSize, Recalculate: resize window
+		PlatformPoint pos = {};
+		PlatformPoint size = {}; // Moved: window size, Resize: client size, DeviceReset: requested back buffer size
+	};
+	static constexpr uint32_t WM_WINDOWEDMODE_COMMANDS = 0x8000 + 1; // WM_APP + 1, posted when the queue gets its first command
+	CommandQueue<WindowCommand, 64> windowCommands;
+	std::atomic<bool> windowCommandsPosted = false; // message on its way, cleared by the drain
+	std::atomic<bool> windowCommandsOverflow = false;
+	bool windowCommandsDraining = false; // window thread only
+
+	MessageWork work = {}; // platformCalls are taken from the platform
+
+	MessageWork GetWork() const
+	{
+		auto current = work;
+		current.platformCalls = platform.calls;
+		return current;
+	}
+
+	void WindowCalculateGeometry(bool center = false, bool resizeWindow = false)
+	{
+		windowUpdating = true;
+		work.geometry++;
+
+		PlatformPoint windowCenter = { windowPos.x + windowSize.x / 2, windowPos.y + windowSize.y / 2 };
+		auto& monitor = monitors.Find(windowCenter);
+		auto monitorRect = monitor.rect;
+		auto monitorWidth = monitorRect.right - monitorRect.left;
+		auto monitorHeight = monitorRect.bottom - monitorRect.top;
+		if (monitorWidth <= 0 || monitorHeight <= 0) // no monitor known, previous geometry is kept
+		{
+			windowUpdating = false;
+			return;
+		}
+
+		bool monitorSingle = monitors.GetCount() <= 1;
+		refreshRate = monitor.refreshRate;
+		monitorSize = { monitorWidth, monitorHeight };
+
+		// size
+		if (windowMode == WindowMode::Fullscreen)
+		{
+			windowPos.x = monitorRect.left;
+			windowPos.y = monitorRect.top;
+			windowSize.x = windowSizeClient.x = monitorWidth;
+			windowSize.y = windowSizeClient.y = monitorHeight;
+		}
+		else if (!platform.IsMaximized()) // not maximized windowed modes
+		{
+			windowSize = SizeFromClient(windowSizeWindowed);
+
+			if (monitorSingle) // limit window size to desktop
+			{
+				if (windowSize.x > monitorWidth) windowSize.x = monitorWidth;
+				if (windowSize.y > monitorHeight) windowSize.y = monitorHeight;
+			}
+
+			windowSizeClient = windowSizeWindowed = ClientFromSize(windowSize);
+
+			// window position
+			if (center)
+			{
+				windowPosWindowed.x = (monitorWidth - windowSize.x) / 2;
+				windowPosWindowed.y = (monitorHeight - windowSize.y) / 2;
+			}
+
+			if (monitorSingle) // keep entire window on the screen
+			{
+				if (windowPosWindowed.x < monitorRect.left) windowPosWindowed.x = monitorRect.left;
+				if (windowPosWindowed.x + windowSize.x > monitorRect.right)
+				{
+					windowPosWindowed.x = monitorRect.right - windowSize.x;
+				}
+
+				if (windowPosWindowed.y < monitorRect.top) windowPosWindowed.y = monitorRect.top;
+				if (windowPosWindowed.y + windowSize.y > monitorRect.bottom)
+				{
+					windowPosWindowed.y = monitorRect.bottom - windowSize.y;
+				}
+			}
+
+			windowPos = windowPosWindowed;
+		}
+
+		// apply to the window
+		if (resizeWindow && !platform.IsMaximized())
+		{
+			StartupMark("Window restyle");
+			platform.SetStyle(WindowStyle(), WindowStyleEx());
+			auto padding = GetFrameSize(true);
+
+			StartupMark("Window move");
+			platform.Move(
+				{ windowPos.x - padding.left, windowPos.y - padding.top },
+				{ windowSize.x, windowSize.y },
+				true);
+
+			WindowUpdateTitle();
+		}
+
+		backBufferSize = BackBufferFromClient(windowSizeClient);
+		PublishPresentRect();
+
+		ApplyBackBuffer();
+
+		windowUpdating = false;
+	}
+
+	void WindowResize(PlatformPoint resolution)
+	{
+		if (fixedBackBuffer) // selected resolution is used for rendering only
+		{
+			fixedBackBufferSize = resolution;
+			WindowCalculateGeometry();
+			return;
+		}
+
+		// Keep fullscreen mode, just update client size info
+		windowSizeWindowed = resolution;
+		WindowCalculateGeometry(false, true);
+		SaveConfig(); // no-op now
+	}
+
+	// settled size, let the game resize its buffers which resets the device
+	void WindowApplyResize(ResizeCoalescer::Size size)
+	{
+		WindowCalculateGeometry(); // presentation params for the reset
+
+		auto type = platform.IsMaximized() ? SizeMaximized : SizeRestored;
+		platform.ForwardMessage(SizeMessage, type, MakeSizeParam({ size.width, size.height }));
+		resizeCoalescer.SetApplied(size); // game knows about it now
+	}
+
+	// settled size is applied, timer stops once nothing is pending
+	void PollResize()
+	{
+		ResizeCoalescer::Size size;
+		if (resizeCoalescer.Poll(platform.Now(), size))
+			WindowApplyResize(size);
+
+		if (!resizeCoalescer.IsPending())
+			platform.KillTimer(ResizeTimer);
+	}
+
+	// any thread
+	void PushCommand(const WindowCommand& command)
+	{
+		if (!windowCommands.Push(command))
+			windowCommandsOverflow = true; // state gets read back from the window instead
+
+		if (!windowCommandsPosted.exchange(true, std::memory_order_acq_rel))
+			platform.Post(WM_WINDOWEDMODE_COMMANDS, 0, 0);
+	}
+
+	// window thread only, on the posted message or right before the device gets created or reset
+	void DrainCommands()
+	{
+		if (!platform.IsWindowThread() || windowCommandsDraining)
+			return; // nested call from a message sent while applying a command
+
+		windowCommandsDraining = true;
+		windowCommandsPosted.exchange(false, std::memory_order_acq_rel); // sees everything pushed before the last post, later pushes post again
+
+		WindowCommand command;
+		while (windowCommands.Pop(command))
+			ApplyCommand(command);
+
+		PlatformRect rect;
+		if (windowCommandsOverflow.exchange(false) && !platform.IsMinimized() && platform.GetWindowRect(rect))
+		{
+			auto padding = GetFrameSize(true);
+			ApplyCommand({
+				WindowCommand::Moved,
+				0,
+				{ rect.left + padding.left, rect.top + padding.top },
+				{ rect.right - rect.left, rect.bottom - rect.top }
+			});
+		}
+
+		windowCommandsDraining = false;
+	}
+
+	void ApplyCommand(const WindowCommand& command)
+	{
+		switch (command.type)
+		{
+			case WindowCommand::Moved:
+			{
+				bool updated = false;
+				bool resized = false;
+
+				if ((command.flags & NoMove) == 0)
+				{
+					if (command.pos.x != windowPos.x || command.pos.y != windowPos.y)
+					{
+						windowPos = command.pos;
+						updated = true;
+					}
+				}
+
+				if ((command.flags & NoSize) == 0)
+				{
+					if (command.size.x != windowSize.x || command.size.y != windowSize.y)
+					{
+						windowSize = command.size;
+						updated = true;
+						resized = true;
+					}
+				}
+
+				if (updated)
+				{
+					windowSizeClient = ClientFromSize(windowSize);
+					if (windowMode != WindowMode::Fullscreen && !platform.IsMaximized())
+					{
+						windowPosWindowed = windowPos;
+						windowSizeWindowed = windowSizeClient;
+					}
+
+					// postpone device reset until the size settles
+					if (resized || resizeCoalescer.IsPending())
+					{
+						auto backBuffer = BackBufferFromClient(windowSizeClient);
+						resizeCoalescer.Resize({ backBuffer.x, backBuffer.y }, platform.Now());
+						if (resizeCoalescer.IsPending())
+							platform.SetTimer(ResizeTimer, uint32_t(resizeCoalescer.settleTime / 4000000)); // few polls per settle time
+						PublishPresentRect(); // old back buffer scaled into the new client area meanwhile
+					}
+					else
+						WindowCalculateGeometry();
+
+					if (resized && fixedBackBuffer)
+						platform.Invalidate(); // clear black bars around scaled image
+
+					WindowUpdateTitle();
+					SaveConfig();
+				}
+				break;
+			}
+
+			case WindowCommand::EndDrag:
+				resizeCoalescer.EndDrag(platform.Now());
+				PollResize();
+				break;
+
+			case WindowCommand::Recalculate:
+				WindowCalculateGeometry(false, command.flags != 0);
+				break;
+
+			case WindowCommand::Resize:
+				WindowResize(command.size);
+				break;
+
+			case WindowCommand::DeviceReset:
+				ApplyDeviceReset(command.size);
+				break;
+		}
+	}
+
+	// D3D device is about to be created, presentation params get filled
+	void BeforeDeviceCreate()
+	{
+		if (!platform.IsWindowThread())
+			return; // params from the window creation are used
+
+		DrainCommands();
+		WindowCalculateGeometry();
+		resizeCoalescer.SetApplied({ backBufferSize.x, backBufferSize.y }); // device gets created with it
+	}
+
+	// D3D device is about to be reset with given back buffer size, presentation params get updated.
+	// From other threads than the window's one the size only gets requested, taking effect with the next reset.
+	void BeforeDeviceReset(PlatformPoint requested)
+	{
+		if (!platform.IsWindowThread())
+		{
+			PushCommand({ WindowCommand::DeviceReset, 0, {}, requested });
+			return;
+		}
+
+		DrainCommands();
+		ApplyDeviceReset(requested);
+	}
+
+	void ApplyDeviceReset(PlatformPoint requested)
+	{
+		work.resets++;
+
+		if (resizeCoalescer.IsPending() || // reset happens anyway, take the pending size now
+			(requested.x == backBufferSize.x && requested.y == backBufferSize.y))
+		{
+			WindowCalculateGeometry(); // update presentation params
+		}
+		else // resolution changed
+		{
+			WindowResize(requested);
+		}
+
+		resizeCoalescer.SetApplied({ backBufferSize.x, backBufferSize.y }); // taken by this reset
+	}
+
+	// window messages
+
+	// WM_WINDOWPOSCHANGED, position or size changed
+	void OnWindowPosChanged(PlatformPoint pos, PlatformPoint size, uint32_t flags)
+	{
+		UpdateClientRect();
+
+		if (windowUpdating || platform.IsMinimized()) return;
+
+		// correct modern Windows styles invisible border
+		auto padding = GetFrameSize(true);
+		PushCommand({
+			WindowCommand::Moved,
+			flags & (NoMove | NoSize),
+			{ pos.x + padding.left, pos.y + padding.top },
+			size
+		});
+	}
+
+	// WM_SIZING, user dragging the window edge. Snaps the window rect to known aspect ratios
+	void OnSizing(uint32_t edge, PlatformRect& wndRect)
+	{
+		auto size = ClientFromSize({
+			wndRect.right - wndRect.left,
+			wndRect.bottom - wndRect.top
+		});
+
+		// minimal game resolution
+		if (size.x < Resolution_Min.x) size.x = Resolution_Min.x;
+		if (size.y < Resolution_Min.y) size.y = Resolution_Min.y;
+
+		// snap to known aspect ratios
+		auto idx = FindAspectRatio(size, 0.02f);
+		if (idx != -1)
+		{
+			auto currAspect = float(size.x) / size.y;
+
+			switch(edge)
+			{
+				case EdgeLeft:
+				case EdgeRight:
+					size.x = int32_t(size.y * AspectRatios[idx].ratio);
+					break;
+
+				case EdgeTop:
+				case EdgeBottom:
+					size.y = int32_t(size.x / AspectRatios[idx].ratio);
+					break;
+
+				default: // sizing both X and Y
+				{
+					if (currAspect < AspectRatios[idx].ratio)
+						size.x = int32_t(size.y * AspectRatios[idx].ratio);
+					else
+						size.y = int32_t(size.x / AspectRatios[idx].ratio);
+				}
+			}
+		}
+
+		// update window title immediately
+		WindowUpdateTitle(&size);
+
+		// apply modified window size
+		size = SizeFromClient(size);
+		if (edge == EdgeLeft || edge == EdgeTopLeft || edge == EdgeBottomLeft) wndRect.left = wndRect.right - size.x;
+		if (edge == EdgeRight || edge == EdgeTopRight || edge == EdgeBottomRight) wndRect.right = wndRect.left + size.x;
+		if (edge == EdgeTop || edge == EdgeTopLeft || edge == EdgeTopRight) wndRect.top = wndRect.bottom - size.y;
+		if (edge == EdgeBottom || edge == EdgeBottomLeft || edge == EdgeBottomRight) wndRect.bottom = wndRect.top + size.y;
+	}
+
+	// WM_EXITSIZEMOVE
+	void OnExitSizeMove()
+	{
+		PushCommand({ WindowCommand::EndDrag }); // resize without waiting for the size to settle
+		PushCommand({ WindowCommand::Recalculate, 1 });
+	}
+
+	// WM_SIZE, tells the game about the new size unless it's held back until settled
+	bool ForwardSize(uint32_t type, PlatformPoint size)
+	{
+		auto backBuffer = BackBufferFromClient(size);
+		if (!FilterSize(type, size))
+			return false;
+
+		platform.ForwardMessage(SizeMessage, type, MakeSizeParam(size));
+		resizeCoalescer.SetApplied({ backBuffer.x, backBuffer.y }); // only once the game has seen it
+		return true;
+	}
+
+	// WM_TIMER, returns false for timers of the game
+	bool OnTimer(uintptr_t id)
+	{
+		if (id != ResizeTimer)
+			return false;
+
+		PollResize();
+		return true;
+	}
+
+	// returns false if the game should not be informed. Size is changed to the one the game should see
+	bool FilterSize(uint32_t type, PlatformPoint& size)
+	{
+		if (type == SizeMinimized || type == SizeMaxHide)
+			return false; // prevent game from updating resolution for minimized window
+
+		if (!windowUpdating)
+		{
+			auto backBuffer = BackBufferFromClient(size);
+			auto applied = resizeCoalescer.GetApplied();
+			if (backBuffer.x != applied.width || backBuffer.y != applied.height)
+				return false; // game gets informed once the size settles
+		}
+
+		if (IsBackBufferScaled())
+			size = backBufferSize; // game renders at back buffer resolution regardless of the window size
+
+		return true;
+	}
+
+	// WM_GETDPISCALEDSIZE, window size keeping the client size on monitor with new DPI
+	PlatformPoint GetDpiScaledSize(uint32_t dpi)
+	{
+		return SizeFromClientForDpi(windowSizeClient, dpi);
+	}
+
+	// WM_DPICHANGED, client size is kept so the back buffer stays the same
+	void OnDpiChanged(uint32_t dpi, PlatformPoint suggestedPos)
+	{
+		monitors.Invalidate();
+		geometryCache.Invalidate();
+
+		auto windowSize = SizeFromClientForDpi(windowSizeClient, dpi);
+		platform.Move(suggestedPos, windowSize, false);
+	}
+
+	// WM_STYLECHANGED, window frame metrics changed
+	void OnStyleChanged()
+	{
+		geometryCache.Invalidate();
+	}
+
+	// WM_DISPLAYCHANGE
+	void OnDisplayChange()
+	{
+		monitors.Invalidate();
+		geometryCache.Invalidate();
+	}
+
+	// WM_SETTINGCHANGE with SPI_SETWORKAREA
+	void OnWorkAreaChange()
+	{
+		monitors.Invalidate();
+	}
+
+	// geometry helpers
+
+	PlatformPoint SizeFromClient(PlatformPoint clientSize) const
+	{
+		auto frame = GetFrameSize();
+		clientSize.x += frame.left + frame.right;
+		clientSize.y += frame.top + frame.bottom;
+		return clientSize;
+	}
+
+	PlatformPoint ClientFromSize(PlatformPoint windowSize) const
+	{
+		auto frame = GetFrameSize();
+		windowSize.x -= frame.left + frame.right;
+		windowSize.y -= frame.top + frame.bottom;
+		return windowSize;
+	}
+
+	// window size for the client size on monitor with given DPI
+	PlatformPoint SizeFromClientForDpi(PlatformPoint clientSize, uint32_t dpi)
+	{
+		auto frame = geometrySource.AdjustFrame(WindowStyle(), WindowStyleEx(), dpi);
+		clientSize.x += frame.left + frame.right;
+		clientSize.y += frame.top + frame.bottom;
+		return clientSize;
+	}
+
+	// size of window frame and extra padding/shadow introduced in later versions of Windows
+	GeometryInsets GetFrameSize(bool padOnly = false) const
+	{
+		return padOnly ?
+			geometryCache.GetPadding(WindowStyle(), WindowStyleEx()) :
+			geometryCache.GetFrame(WindowStyle(), WindowStyleEx());
+	}
+
+	// also picks refresh rate of the monitor showing the window
+	void UpdateClientRect()
+	{
+		PlatformRect rect;
+		if (!platform.GetClientRect(rect))
+			return;
+
+		inputState.SetClientRect(rect);
+		refreshRate = monitors.Find({ (rect.left + rect.right) / 2, (rect.top + rect.bottom) / 2 }).refreshRate; // window may move to another monitor
+	}
+
+	PlatformPoint BackBufferFromClient(PlatformPoint clientSize) const
+	{
+		if (!fixedBackBuffer)
+		{
+			auto scale = renderScale < RenderScale_Min ? RenderScale_Min : renderScale > RenderScale_Max ? RenderScale_Max : renderScale;
+			if (scale == 1.0f)
+				return clientSize;
+
+			PlatformPoint size = { int32_t(clientSize.x * scale + 0.5f), int32_t(clientSize.y * scale + 0.5f) };
+			return { size.x > 1 ? size.x : 1, size.y > 1 ? size.y : 1 };
+		}
+
+		if (fixedBackBufferSize.x > 0 && fixedBackBufferSize.y > 0)
+			return fixedBackBufferSize;
+
+		return monitorSize; // native resolution
+	}
+
+	bool IsBackBufferScaled() const
+	{
+		return backBufferSize.x != windowSizeClient.x || backBufferSize.y != windowSizeClient.y;
+	}
+
+	// any thread, false if the back buffer fills the client area as is
+	bool GetPresentRect(ScaleRect& rect) const
+	{
+		auto packed = presentRect.load(std::memory_order_acquire);
+		if (!packed)
+			return false;
+
+		rect = { int16_t(packed), int16_t(packed >> 16), int16_t(packed >> 32), int16_t(packed >> 48) };
+		return true;
+	}
+
+	void PublishPresentRect()
+	{
+		uint64_t packed = 0;
+		if (IsBackBufferScaled())
+		{
+			auto rect = PresentRect();
+			packed = uint64_t(uint16_t(rect.left)) | uint64_t(uint16_t(rect.top)) << 16 | uint64_t(uint16_t(rect.right)) << 32 | uint64_t(uint16_t(rect.bottom)) << 48;
+		}
+		presentRect.store(packed, std::memory_order_release);
+	}
+
+	// back buffer area in the client area
+	ScaleRect PresentRect() const
+	{
+		auto policy = fixedBackBuffer ? fixedBackBufferScaling : ScalePolicy::Fill;
+		return ScaleToFit(backBufferSize.x, backBufferSize.y, windowSizeClient.x, windowSizeClient.y, policy);
+	}
+
+	// width and height packed like in WM_SIZE
+	static intptr_t MakeSizeParam(PlatformPoint size)
+	{
+		return intptr_t(uint32_t(uint16_t(size.x)) | uint32_t(uint16_t(size.y)) << 16);
+	}
+};
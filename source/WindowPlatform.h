@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+struct PlatformPoint
+{
+	int32_t x, y;
+};
+
+struct PlatformRect
+{
+	int32_t left, top, right, bottom;
+};
+
+struct MonitorInfo
+{
+	PlatformRect rect;
+	PlatformRect workArea; // without taskbar and docked windows
+	uint32_t refreshRate; // Hz, 0 if unknown
+	uint32_t dpi;
+	bool primary;
+};
+
+// Window manipulation and display queries used by the window code, implemented by the platform (or simulated).
+// Every call except reading the clock is counted, so the work done per window message can be measured.
+// Calls the message handlers make straight to Win32 are not, see MessageWork.
+class WindowPlatform
+{
+public:
+	std::atomic<uint32_t> calls = 0; // statistics, counted by the implementation
+
+	virtual ~WindowPlatform() = default;
+
+	virtual int64_t Now() = 0; // monotonic time in ns
+	virtual void GetMonitors(std::vector<MonitorInfo>& monitors) = 0; // appends all connected monitors
+	virtual bool IsMaximized() = 0;
+	virtual bool IsMinimized() = 0;
+	virtual bool IsForeground() = 0;
+	virtual bool GetWindowRect(PlatformRect& rect) = 0; // outer window rect, false if there is no window yet
+	virtual bool GetClientRect(PlatformRect& rect) = 0; // in screen coordinates, false if there is no window yet
+	virtual void SetStyle(uint32_t style, uint32_t exStyle) = 0; // also updates the frame and shows the window
+	virtual void Move(PlatformPoint pos, PlatformPoint size, bool show) = 0; // outer window rect, activated if shown, z-order and activation untouched otherwise
+	virtual void Invalidate() = 0; // whole window gets repainted
+	virtual void Post(uint32_t message, uintptr_t wParam, intptr_t lParam) = 0; // to the window's own message queue, from any thread
+	virtual bool IsWindowThread() = 0; // called from the thread owning the window, true if there is no window yet
+	virtual void SetTimer(uintptr_t id, uint32_t interval) = 0; // ms, replaces running timer with the same id
+	virtual void KillTimer(uintptr_t id) = 0;
+	virtual intptr_t ForwardMessage(uint32_t message, uintptr_t wParam, intptr_t lParam) = 0; // to the game's window procedure
+};
@@ -2,46 +2,157 @@
 #include "Windowed_Gta3.h"
 #include "Windowed_GtaVC.h"
 #include "Windowed_GtaSA.h"
-#include <dwmapi.h>
 
 #pragma comment(lib, "dwmapi.lib") // DwmGetWindowAttribute
 #pragma comment(lib, "winmm.lib") // timeGetTime
 
-// list of popular display aspect ratios
-const WindowedMode::AspectRatioInfo WindowedMode::AspectRatios[] = {
-	{ "1:1", 1.0f / 1.0f },
-	{ "2:1", 2.0f / 1.0f },
-	{ "4:3", 4.0f / 3.0f },
-	{ "5:4", 5.0f / 4.0f },
-	{ "10:7", 10.0f / 7.0f }, // GTA default aspect
-	{ "16:9", 16.0f / 9.0f },
-	{ "16:10", 16.0f / 10.0f }
-};
-
-WindowedMode::WindowedMode(
-	GameTitle gameTitle,
-	uintptr_t gameState,
-	uintptr_t rsGlobal,
-	uintptr_t d3dDevice,
-	uintptr_t d3dPresentParams,
-	uintptr_t rwVideoModes,
-	uintptr_t RwEngineGetNumVideoModes,
-	uintptr_t RwEngineGetCurrentVideoMode,
-	uintptr_t frontEndMenuManager
-) :
-	gameTitle(gameTitle),
-	gameState(*(GameState*)gameState),
-	rsGlobal((RsGlobalType*)rsGlobal),
-	d3dDevice(*(IDirect3DDevice8**)d3dDevice),
-	d3dPresentParams8((D3DPRESENT_PARAMETERS*)d3dPresentParams),
-	rwVideoModes((DisplayMode**)rwVideoModes),
-	RwEngineGetNumVideoModes(*(DWORD(*)())RwEngineGetNumVideoModes),
-	RwEngineGetCurrentVideoMode(*(DWORD(*)())RwEngineGetCurrentVideoMode),
-	frontEndMenuManager(frontEndMenuManager)
+WindowedMode::WindowedMode(GameTitle gameTitle) :
+	WindowController(win32Platform, win32Geometry),
+	gameTitle(gameTitle)
 {}
 
+template <class Traits>
+WindowedMode* WindowedMode::Create()
+{
+	return new WindowedMode(Traits::Title);
+}
+
+void WindowedMode::Arm()
+{
+	auto span = startupTimeline.Begin("DllMain", QpcClock().Now());
+	errorsDeferred = true; // no message boxes under the loader lock
+
+	// loaded late, not by the ASI loader: the window is there and the import won't be called again
+	bool windowExists = FindProcessWindow(Gta3Traits::WindowClass) || FindProcessWindow(GtaSATraits::WindowClass);
+
+	// redirect game's CreateWindowExA import, everything else happens there outside of the loader lock
+	if (!windowExists) createWindowImport = FindImport(GetModuleHandle(NULL), "user32.dll", "CreateWindowExA");
+	if (createWindowImport)
+	{
+		createWindowOri = (decltype(createWindowOri))*createWindowImport;
+
+		const PatchOp patches[] = { PatchOp::Write((uintptr_t)createWindowImport, (uintptr_t)&CreateWindowHook) };
+		if (!ApplyPatches(patches)) createWindowImport = nullptr;
+	}
+
+	startupTimeline.End(span, QpcClock().Now());
+
+	if (!createWindowImport)
+	{
+		EnableDpiAwareness(true); // no library loading under the loader lock
+		Init(); // initialize right away then, warns about the missing ASI loader if the window exists
+	}
+	ShowDeferredErrors();
+}
+
+bool WindowedMode::Init()
+{
+	QpcClock clock;
+
+	auto span = startupTimeline.Begin("Version detection", clock.Now());
+	char name[128];
+	injector::address_manager::singleton().GetVersionText(name);
+	startupTimeline.End(span, clock.Now());
+
+	span = startupTimeline.Begin("Patching", clock.Now());
+	if (!_stricmp(name, "GTA III 1.0.0.0 UNK_REGION"))
+	{
+		InitGta3();
+	}
+	else if (!_stricmp(name, "GTA VC 1.0.0.0 UNK_REGION"))
+	{
+		InitGtaVC();
+	}
+	else if (!_stricmp(name, "GTA SA 1.0.0.0 US"))
+	{
+		InitGtaSA();
+	}
+	else if (!InitBySignature())
+	{
+		ShowError("Game version \"%s\" is not supported! \nSee readme file.", name);
+	}
+	startupTimeline.End(span, clock.Now());
+
+	return inst != nullptr;
+}
+
+bool WindowedMode::InitBySignature()
+{
+	auto span = startupTimeline.Begin("Signature scan", QpcClock().Now());
+
+	// Version text not recognized, executable may still have the code of a supported version (e.g. modified headers).
+	// Game calls CreateWindowExA through its import table once, its address tells which version the code is from.
+	auto module = GetModuleHandle(NULL);
+	auto import = createWindowImport ? createWindowImport : FindImport(module, "user32.dll", "CreateWindowExA");
+	auto slot = (uint32_t)(uintptr_t)import;
+	auto pattern = StringPrintf("FF 15 %02X %02X %02X %02X", slot & 0xFF, (slot >> 8) & 0xFF, (slot >> 16) & 0xFF, slot >> 24); // call dword ptr [slot]
+
+	// results of earlier launches with the same executable
+	SignatureResolver resolver((const uint8_t*)module);
+	FILE* file;
+	if (!fopen_s(&file, rsc_ProductName ".cache", "rb"))
+	{
+		resolver.LoadCache(file);
+		fclose(file);
+	}
+
+	auto call = import ? resolver.Resolve("CreateWindowExA call", pattern.c_str()) : 0;
+
+	if (resolver.IsCacheModified() && !fopen_s(&file, rsc_ProductName ".cache", "wb"))
+	{
+		resolver.SaveCache(file);
+		fclose(file);
+	}
+	startupTimeline.End(span, QpcClock().Now());
+
+	if (call == Gta3Traits::CreateWindowCall)
+		InitGta3();
+	else if (call == GtaVCTraits::CreateWindowCall)
+		InitGtaVC();
+	else if (call == GtaSATraits::CreateWindowCall)
+		InitGtaSA();
+	else
+		return false; // other code layout, its addresses are not known
+
+	return true;
+}
+
+void WindowedMode::ReportStartup()
+{
+	auto origin = startupTimeline.GetOrigin();
+	for (size_t i = 0; i < startupTimeline.GetCount(); i++)
+	{
+		auto& span = startupTimeline.Get(i);
+		auto msg = StringPrintf(rsc_ProductName ": %s at %.3f ms took %.3f ms\n", span.name, (span.begin - origin) / 1e6, (span.end - span.begin) / 1e6);
+		OutputDebugStringA(msg.c_str());
+	}
+}
+
+HWND __stdcall WindowedMode::CreateWindowHook(DWORD dwExStyle, LPCSTR lpClassName, LPCSTR lpWindowName, DWORD dwStyle, int X, int Y, int nWidth, int nHeight, HWND hWndParent, HMENU hMenu, HINSTANCE hInstance, LPVOID lpParam)
+{
+	// first call only, from now on the game's call site is patched directly
+	const PatchOp patches[] = { PatchOp::Write((uintptr_t)createWindowImport, (uintptr_t)createWindowOri) };
+	ApplyPatches(patches);
+
+	// before the window is created or anything queries geometry, so all of it is in real pixels
+	EnableDpiAwareness();
+
+	if (Init() && !IS_INTRESOURCE(lpClassName) && !_stricmp(lpClassName, inst->windowClassName))
+	{
+		return InitWindow(dwExStyle, lpClassName, lpWindowName, dwStyle, X, Y, nWidth, nHeight, hWndParent, hMenu, hInstance, lpParam);
+	}
+
+	return createWindowOri(dwExStyle, lpClassName, lpWindowName, dwStyle, X, Y, nWidth, nHeight, hWndParent, hMenu, hInstance, lpParam);
+}
+
 HWND __stdcall WindowedMode::InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPCSTR lpWindowName, DWORD dwStyle, int X, int Y, int nWidth, int nHeight, HWND hWndParent, HMENU hMenu, HINSTANCE hInstance, LPVOID lpParam)
 {
+	auto span = inst->StartupBegin("InitWindow");
+
+	// awareness was just set by CreateWindowHook, metrics queried before it were virtualized
+	inst->monitors.Invalidate();
+	inst->geometryCache.Invalidate();
+
 	WNDCLASSA oriClass;
 	if (!GetClassInfo(hInstance, inst->windowClassName, &oriClass))
 	{
@@ -50,7 +161,7 @@ HWND __stdcall WindowedMode::InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPC
 	}
 	inst->oriWindowProc = oriClass.lpfnWndProc;
 
-	// apply our hardcoded config (no ini)
+	// apply our hardcoded config, only render and frame limiter settings come from the ini
 	inst->LoadConfig();
 
 	// Force borderless fullscreen, ignore ini resolution/pos if needed
@@ -64,8 +175,6 @@ HWND __stdcall WindowedMode::InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPC
 	inst->WindowCalculateGeometry(center);
 	inst->WindowUpdateTitle();
 
-
-
 	WNDCLASSA wndClass;
 	wndClass.hInstance = hInstance;
 	wndClass.lpszClassName = inst->windowClassName;
@@ -81,10 +190,12 @@ HWND __stdcall WindowedMode::InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPC
 	UnregisterClass(inst->windowClassName, hInstance);
 	RegisterClass(&wndClass);
 
+	// created once with final style, position and size
+	inst->StartupMark("CreateWindowEx");
 	inst->window = CreateWindowEx(
 		inst->WindowStyleEx(),
 		inst->windowClassName,
-		inst->windowTitle,
+		inst->windowTitle.c_str(),
 		inst->WindowStyle(),
 		inst->windowPos.x, inst->windowPos.y,
 		inst->windowSize.x, inst->windowSize.y,
@@ -93,46 +204,72 @@ HWND __stdcall WindowedMode::InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPC
 		hInstance,
 		0);
 
-	inst->WindowCalculateGeometry(center, true);
+	inst->geometryCache.Invalidate(); // metrics so far were queried without the window
+	// focus messages sent during creation were already seen, the handle is taken from the first one.
+	// Seeded anyway for a window created without being activated, and creation sends no WM_WINDOWPOSCHANGED for the client area
+	inst->inputState.SetFocus(inst->platform.IsForeground());
+	inst->UpdateClientRect();
+
+	// invisible resize borders are known only once the window exists
+	auto padding = inst->GetFrameSize(true);
+	if (padding.left || padding.top)
+	{
+		inst->StartupMark("Window move");
+		inst->platform.Move(
+			{ inst->windowPos.x - padding.left, inst->windowPos.y - padding.top },
+			{ inst->windowSize.x, inst->windowSize.y },
+			false);
+	}
+
+	inst->WindowCalculateGeometry(center); // pass the window handle to the game
 
 	UpdateWindow(inst->window);
 	inst->MouseUpdate(true); // lock cursor in the window until main menu appears
 
+	inst->StartupEnd(span);
 	return inst->window;
 }
 
+template <class Traits>
 void WindowedMode::InitD3dDevice()
 {
+	StartupEnd(startupDeviceSpan);
+
+	auto d3dDevice = *(IDirect3DDevice8**)Traits::D3dDevice;
 	if (d3dDevice == nullptr)
 	{
 		return;
 	}
 
-	auto vTable = *(uintptr_t**)d3dDevice;
-	DWORD oldProtect;
-	injector::UnprotectMemory(vTable, 20 * sizeof(uintptr_t), oldProtect);
-
-	if (IsD3D9())
-	{
-		d3dResetOri = reinterpret_cast<decltype(d3dResetOri)>(vTable[16]);
-		vTable[16] = (uintptr_t)&D3dResetHook;
-
-		d3dPresentOri = reinterpret_cast<decltype(d3dPresentOri)>(vTable[17]);
-		vTable[17] = (uintptr_t)&D3dPresentHook;
-	}
-	else
-	{
-		d3dResetOri = reinterpret_cast<decltype(d3dResetOri)>(vTable[14]);
-		vTable[14] = (uintptr_t)&D3dResetHook;
+	PatchOp patches[2];
+	auto original = DeviceVTable<Traits::D3D9>::Redirect(*(uintptr_t**)d3dDevice, { (uintptr_t)&D3dResetHook<Traits>, (uintptr_t)&D3dPresentHook<Traits> }, patches);
+	d3dResetOri = reinterpret_cast<ResetFunc>(original.reset);
+	d3dPresentOri = reinterpret_cast<PresentFunc>(original.present);
 
-		d3dPresentOri = reinterpret_cast<decltype(d3dPresentOri)>(vTable[15]);
-		vTable[15] = (uintptr_t)&D3dPresentHook;
-	}
+	ApplyPatches(patches);
+	UpdatePresentRectSupport<Traits>();
 }
 
 void WindowedMode::InitConfig()
 {
-	// Do nothing  ini is ignored
+	// settings missing in the ini are written with their defaults, so they can be found and edited
+	auto init = [this](const char* section, const char* key, int value)
+	{
+		if (config.ReadInteger(section, key, INT_MIN) == INT_MIN)
+			config.WriteInteger(section, key, value);
+	};
+
+	if (config.ReadFloat("Render", "RenderScale", -1.0f) < 0.0f)
+		config.WriteFloat("Render", "RenderScale", 1.0f);
+	init("Render", "FixedBackBuffer", 0);
+	init("Render", "FixedBackBufferWidth", 0);
+	init("Render", "FixedBackBufferHeight", 0);
+	init("Render", "Scaling", (int)ScalePolicy::AspectFit);
+
+	init("FrameLimiter", "Strategy", (int)PacingStrategy::Hybrid);
+	init("FrameLimiter", "Gameplay", -1);
+	init("FrameLimiter", "Menu", -1);
+	init("FrameLimiter", "Unfocused", 5);
 }
 
 bool WindowedMode::LoadConfig()
@@ -145,7 +282,26 @@ bool WindowedMode::LoadConfig()
 	windowPos = windowPosWindowed;
 	windowSize = windowSizeClient = windowSizeWindowed;
 
-	menuFrameRateLimit = 0;
+	InitConfig();
+
+	// back buffer of fixed size scaled into the window, zero size is the monitor's native resolution
+	fixedBackBuffer = config.ReadInteger("Render", "FixedBackBuffer", 0) != 0;
+	fixedBackBufferSize.x = (std::max)(config.ReadInteger("Render", "FixedBackBufferWidth", 0), 0);
+	fixedBackBufferSize.y = (std::max)(config.ReadInteger("Render", "FixedBackBufferHeight", 0), 0);
+	auto scaling = config.ReadInteger("Render", "Scaling", (int)ScalePolicy::AspectFit);
+	fixedBackBufferScaling = (scaling >= 0 && scaling <= (int)ScalePolicy::IntegerScale) ? (ScalePolicy)scaling : ScalePolicy::AspectFit;
+	renderScale = config.ReadFloat("Render", "RenderScale", 1.0f); // clamped when used
+
+	// frame limiter targets are read from the ini too, everything in [FrameLimiter] is optional
+	auto& frameLimiter = presenter.frameLimiter;
+	auto strategy = config.ReadInteger("FrameLimiter", "Strategy", (int)PacingStrategy::Hybrid);
+	frameLimiter.pacer.strategy = (strategy >= 0 && strategy <= (int)PacingStrategy::BusyWait) ? (PacingStrategy)strategy : PacingStrategy::Hybrid;
+	frameLimiter.targets[frameLimiter.Gameplay] = frameLimiter.ConfigTarget(config.ReadInteger("FrameLimiter", "Gameplay", -1)); // monitor refresh rate
+	frameLimiter.targets[frameLimiter.Menu] = frameLimiter.ConfigTarget(config.ReadInteger("FrameLimiter", "Menu", -1));
+	frameLimiter.targets[frameLimiter.Unfocused] = frameLimiter.ConfigTarget(config.ReadInteger("FrameLimiter", "Unfocused", 5)); // background throttling
+	presenter.focusThrottle.enabled = true;
+	presenter.focusThrottle.skipPresentMinimized = true;
+	rawMouse = true;
 	autoPause = false;
 	autoResume = false;
 
@@ -158,27 +314,7 @@ void WindowedMode::SaveConfig()
 }
 
 
-int WindowedMode::FindAspectRatio(POINT resolution, float treshold)
-{
-	auto ratio = float(resolution.x) / resolution.y;
-
-	// find best match in
-	int idx = -1;
-	float dist = 9999.0f;
-	for (size_t i = 0; i < _countof(AspectRatios); i++)
-	{
-		auto diff = fabs(AspectRatios[i].ratio - ratio);
-		if (diff < dist)
-		{
-			idx = i;
-			dist = diff;
-		}
-	}
-
-	return dist <= treshold ? idx : -1;
-}
-
-DWORD WindowedMode::WindowStyle() const
+uint32_t WindowedMode::WindowStyle() const
 {
 	return WS_VISIBLE | WS_CLIPSIBLINGS | ((windowMode == WindowMode::Windowed) ?
 		WS_OVERLAPPEDWINDOW :
@@ -186,196 +322,92 @@ DWORD WindowedMode::WindowStyle() const
 }
 
 
-DWORD WindowedMode::WindowStyleEx() const
+uint32_t WindowedMode::WindowStyleEx() const
 {
 	return (windowMode == WindowMode::Windowed) ?
 		0 : // WS_EX_CLIENTEDGE
 		0;
 }
 
-void WindowedMode::WindowCalculateGeometry(bool center, bool resizeWindow)
+void WindowedMode::WindowModeCycle()
 {
-	windowUpdating = true;
 
-	POINT windowCenter = { windowPos.x + windowSize.x / 2, windowPos.y + windowSize.y / 2};
-	auto monitorRect = GetMonitorRect(windowCenter);
-	auto monitorWidth = monitorRect.right - monitorRect.left;
-	auto monitorHeight = monitorRect.bottom - monitorRect.top;
-	bool monitorSingle = GetSystemMetrics(SM_CMONITORS) <= 1;
-
-	// size
-	if (windowMode == WindowMode::Fullscreen)
-	{
-		windowPos.x = monitorRect.left;
-		windowPos.y = monitorRect.top;
-		windowSize.x = windowSizeClient.x = monitorWidth;
-		windowSize.y = windowSizeClient.y = monitorHeight;
-	}
-	else if (!IsZoomed(window)) // not maximized windowed modes
-	{
-		windowSize = SizeFromClient(windowSizeWindowed);
-
-		if (monitorSingle) // limit window size to desktop
-		{
-			windowSize.x = min(windowSize.x, monitorWidth);
-			windowSize.y = min(windowSize.y, monitorHeight);
-		}
-
-		windowSizeClient = windowSizeWindowed = ClientFromSize(windowSize);
+}
 
-		// window position
-		if (center)
-		{
-			windowPosWindowed.x = (monitorWidth - windowSize.x) / 2;
-			windowPosWindowed.y = (monitorHeight - windowSize.y) / 2;
-		}
-		
-		if (monitorSingle) // keep entire window on the screen
-		{
-			windowPosWindowed.x = max(windowPosWindowed.x, monitorRect.left);
-			if (windowPosWindowed.x + windowSize.x > monitorRect.right)
-			{
-				windowPosWindowed.x = monitorRect.right - windowSize.x;
-			}
+void WindowedMode::ApplyBackBuffer()
+{
+	ForGame([this](auto traits) { ApplyGameResolution<decltype(traits)>(); });
+}
 
-			windowPosWindowed.y = max(windowPosWindowed.y, monitorRect.top);
-			if (windowPosWindowed.y + windowSize.y > monitorRect.bottom)
-			{
-				windowPosWindowed.y = monitorRect.bottom - windowSize.y;
-			}
-		}
+void WindowedMode::WindowUpdateTitle(const PlatformPoint* clientSize)
+{
+	if (!clientSize)
+		clientSize = &windowSizeClient;
 
-		windowPos = windowPosWindowed;
-	}
+	windowTitle.Clear();
+	windowTitle.Append(ForGame([](auto traits) { return GetRsGlobal<decltype(traits)>().AppName; }));
 
-	// apply to the window
-	if (resizeWindow && !IsZoomed(window))
+	if (inputState.HasFocus())
 	{
-		SetWindowLong(window, GWL_STYLE, WindowStyle());
-		SetWindowLong(window, GWL_EXSTYLE, WindowStyleEx());
-		SetWindowPos(window, 0, 0, 0, 0, 0, SWP_NOOWNERZORDER | SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOSIZE | SWP_NOSENDCHANGING | SWP_FRAMECHANGED | SWP_SHOWWINDOW); // update the frame
-		auto padding = GetFrameSize(true);
-
-		SetWindowPos(window, 0,
-			windowPos.x - padding.left,
-			windowPos.y - padding.top,
-			windowSize.x,
-			windowSize.y,
-			SWP_NOOWNERZORDER | SWP_NOSENDCHANGING | SWP_SHOWWINDOW);
+		windowTitle.Append(" | ").Append(uint32_t(clientSize->x)).Append('x').Append(uint32_t(clientSize->y));
 
-		WindowUpdateTitle();
+		auto idx = FindAspectRatio(*clientSize);
+		if (idx != -1)
+			windowTitle.Append(" (").Append(AspectRatios[idx].name).Append(')');
+
+		auto& frameSummary = presenter.frameSummary;
+		windowTitle.Append(" @ ").Append(frameSummary.Fps()).Append(" fps")
+			.Append(" | avg ").AppendMs(frameSummary.avg)
+			.Append(" p50 ").AppendMs(frameSummary.p50)
+			.Append(" p99 ").AppendMs(frameSummary.p99)
+			.Append(" p99.9 ").AppendMs(frameSummary.p999)
+			.Append(" max ").AppendMs(frameSummary.max)
+			.Append(" ms");
 	}
 
-	// apply resolution to game internals
-	if (gameTitle == GameTitle::GTA_SA)
-	{
-		rsGlobalSA->ps->fullScreen = false;
-		rsGlobalSA->ps->window = window;
-		rsGlobalSA->MaximumWidth = windowSizeClient.x;
-		rsGlobalSA->MaximumHeight = windowSizeClient.y;
-	}
-	else
-	{
-		rsGlobal->ps->fullScreen = false;
-		rsGlobal->ps->window = window;
-		rsGlobal->screenWidth = rsGlobal->MaximumWidth = windowSizeClient.x;
-		rsGlobal->screenHeight = rsGlobal->MaximumHeight = windowSizeClient.y;
-	}
+	if (window)
+		titleUpdater.Post(windowTitle); // applied by helper thread
+}
 
-	if (IsD3D9())
-	{
-		d3dPresentParams9->Windowed = TRUE;
-		d3dPresentParams9->hDeviceWindow = window;
-		d3dPresentParams9->BackBufferWidth = windowSizeClient.x;
-		d3dPresentParams9->BackBufferHeight = windowSizeClient.y;
-		d3dPresentParams9->BackBufferFormat = D3DFMT_A8R8G8B8;
-		d3dPresentParams9->SwapEffect = D3DSWAPEFFECT_DISCARD;
-		d3dPresentParams9->FullScreen_PresentationInterval = D3DPRESENT_INTERVAL_DEFAULT;
-		d3dPresentParams9->FullScreen_RefreshRateInHz = 0;
-	}
-	else
-	{
-		d3dPresentParams8->Windowed = TRUE;
-		d3dPresentParams8->hDeviceWindow = window;
-		d3dPresentParams8->BackBufferWidth = windowSizeClient.x;
-		d3dPresentParams8->BackBufferHeight = windowSizeClient.y;
-		d3dPresentParams8->BackBufferFormat = D3DFMT_X8R8G8B8;
-		d3dPresentParams8->SwapEffect = D3DSWAPEFFECT_DISCARD;
-		d3dPresentParams8->FullScreen_PresentationInterval = D3DPRESENT_INTERVAL_DEFAULT;
-		d3dPresentParams8->FullScreen_RefreshRateInHz = 0;
-	}
+LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	if (!inst->window) inst->window = wnd; // messages sent from within CreateWindowEx come before it returns the handle
 
-	// write the resolution into video display modes list
-	if (*rwVideoModes)
+	// structures behind pointers are recorded by value, so the trace can be replayed
+	auto tracedWParam = (uint32_t)wParam;
+	auto tracedLParam = (uint32_t)lParam;
+	switch (msg)
 	{
-		// backup display modes infos before making any changes
-		static std::vector<DisplayMode> videoModesBackup;
-		if (videoModesBackup.empty())
+		case WM_WINDOWPOSCHANGED:
 		{
-			auto count = RwEngineGetNumVideoModes();
-			videoModesBackup.resize(count);
-			memcpy(videoModesBackup.data(), *rwVideoModes, count * sizeof(DisplayMode));
+			auto info = (const WINDOWPOS*)lParam;
+			tracedWParam = MessageTrace::PackPoint({ info->x, info->y });
+			tracedLParam = MessageTrace::PackSize({ info->cx, info->cy }, info->flags);
+			break;
 		}
 
-		static int prevVideoMode = -1;
-		int currVideoMode = RwEngineGetCurrentVideoMode();
-	
-		// restore previous display mode info to its original state
-		if (prevVideoMode != -1 && currVideoMode != prevVideoMode) (*rwVideoModes)[prevVideoMode] = videoModesBackup[prevVideoMode];
-		prevVideoMode = currVideoMode;
-
-		// write modified resolution into current display mode info
-		auto& mode = (*rwVideoModes)[currVideoMode];
-		mode.width = windowSizeClient.x;
-		mode.height = windowSizeClient.y;
-		mode.format = IsD3D9() ? d3dPresentParams9->BackBufferFormat : d3dPresentParams8->BackBufferFormat;
-		mode.refreshRate = IsD3D9() ? d3dPresentParams9->FullScreen_RefreshRateInHz : d3dPresentParams8->FullScreen_RefreshRateInHz;
-		mode.flags &= ~1; // clear fullscreen flag
-	}
-
-	windowUpdating = false;
-}
-
-void WindowedMode::WindowResize(POINT resolution)
-{
-	// Keep fullscreen mode, just update client size info
-	windowSizeWindowed = resolution;
-	WindowCalculateGeometry(false, true);
-	SaveConfig(); // no-op now
-}
-
-
-void WindowedMode::WindowModeCycle()
-{
-
-}
-
-void WindowedMode::WindowUpdateTitle()
-{
-	if (windowMode == WindowMode::Windowed && HasFocus(window))
-	{
-		std::string aspectTxt;
-		auto idx = FindAspectRatio(windowSizeClient);
-		if (idx != -1)
+		case WM_SIZING:
 		{
-			aspectTxt = StringPrintf(" (%s)", AspectRatios[idx].name);
+			auto rect = (const RECT*)lParam;
+			tracedLParam = MessageTrace::PackPoint({ rect->right - rect->left, rect->bottom - rect->top });
+			break;
 		}
 
-		sprintf_s(windowTitle, "%s | %ux%u%s @ %u fps",
-			rsGlobal->AppName,
-			windowSizeClient.x,
-			windowSizeClient.y,
-			aspectTxt.c_str(),
-			fpsCounter.get());
+		case WM_DPICHANGED:
+		{
+			auto rect = (const RECT*)lParam;
+			tracedLParam = MessageTrace::PackPoint({ rect->left, rect->top });
+			break;
+		}
 	}
-	else
-		strcpy_s(windowTitle, rsGlobal->AppName);
-	
-	if (window)
-		SetWindowText(window, windowTitle);
+
+	auto ticket = inst->messageTrace.Begin(msg, tracedWParam, tracedLParam, inst->platform.Now(), inst->GetWork());
+	auto result = HandleMessage(wnd, msg, wParam, lParam);
+	inst->messageTrace.End(ticket, (int32_t)result, inst->platform.Now(), inst->GetWork());
+	return result;
 }
 
-LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam)
+LRESULT WindowedMode::HandleMessage(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
 	switch (msg)
 	{
@@ -385,9 +417,15 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 		// window focus/defocus
 	case WM_ACTIVATE:
 	{
+		inst->inputState.SetFocus(LOWORD(wParam) != WA_INACTIVE);
+		if (LOWORD(wParam) == WA_INACTIVE)
+			inst->rawMouseButtons = 0; // releases happening in other windows are not reported
+
 		auto result = (LOWORD(wParam) == WA_INACTIVE) ?
 			DefWindowProc(wnd, msg, wParam, lParam) :
-			CallWindowProc(inst->oriWindowProc, wnd, msg, wParam, lParam);
+			inst->platform.ForwardMessage(msg, wParam, lParam);
+
+		inst->presenter.focusThrottle.OnActivate(LOWORD(wParam) != WA_INACTIVE, HIWORD(wParam) != 0);
 
 		bool altDown = (GetAsyncKeyState(VK_MENU) & 0x8000) != 0;
 		bool altTabMinimize = (LOWORD(wParam) == WA_INACTIVE) && altDown;
@@ -396,7 +434,7 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 		{
 			ShowWindow(wnd, SW_MINIMIZE);
 
-			if (inst->gameState == Playing_Game && !inst->IsMainMenuVisible())
+			if (inst->GetGameState() == Playing_Game && !inst->IsMainMenuVisible())
 				inst->SwitchMainMenu(true);
 		}
 
@@ -416,6 +454,7 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 		// don't pause game on defocus
 		case WM_SETFOCUS:
 		case WM_KILLFOCUS:
+			inst->inputState.SetFocus(msg == WM_SETFOCUS);
 			return DefWindowProc(wnd, msg, wParam, lParam);
 		
 		// restore proper handling of ShowCursor
@@ -427,7 +466,7 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 
 		case WM_SYSKEYDOWN:
 		{
-			if (!HasFocus(wnd))
+			if (!inst->inputState.HasFocus())
 				return DefWindowProc(wnd, msg, wParam, lParam); // bypass the game
 			
 			// handle Alt+Enter key combination
@@ -437,6 +476,18 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 				return DefWindowProc(wnd, msg, wParam, lParam); // bypass the game
 			}
 
+			// handle Ctrl+Alt+T key combination
+			if (wParam == 'T' && IsKeyDown(VK_CONTROL) && IsKeyDown(VK_MENU))
+			{
+				inst->frameTraceDumpRequested = true; // ring is written by the present hook
+				inst->inputLatencyDumpRequested = true;
+				inst->DumpMessageTrace();
+				inst->DumpStartupTimeline();
+				inst->frameStatsDumpRequested = true;
+				return DefWindowProc(wnd, msg, wParam, lParam); // bypass the game
+			}
+
+			inst->presenter.inputLatency.Input(InputClass::Keyboard, inst->platform.Now());
 			break;
 		}
 
@@ -458,21 +509,81 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 		case WM_MOUSEMOVE:
 		case WM_MOUSEWHEEL:
 		{
-			auto hasFocus = HasFocus(wnd);
-			auto inClient = IsCursorInClientRect(wnd);
+			// decided from the message alone, focus and client area are kept up to date by their own messages
+			auto hasFocus = inst->inputState.HasFocus();
+			PlatformPoint pos = { (short)LOWORD(lParam), (short)HIWORD(lParam) };
+			bool inClient;
+			if (msg == WM_MOUSEACTIVATE)
+				inClient = LOWORD(lParam) == HTCLIENT; // hit test code instead of position
+			else if (msg == WM_MOUSEWHEEL)
+				inClient = inst->inputState.IsInClientScreen(pos);
+			else
+				inClient = inst->inputState.IsInClient(pos);
 
 			if (!hasFocus && inClient)
 			{
-				SetCursor(LoadCursor(NULL,IDC_ARROW));
+				static auto arrow = LoadCursor(NULL, IDC_ARROW);
+				SetCursor(arrow);
 			}
 
 			if (!hasFocus || !inClient)
 			{
 				return DefWindowProc(wnd, msg, wParam, lParam); // bypass the game
 			}
+
+			if (msg == WM_MOUSEMOVE)
+				inst->presenter.inputLatency.Input(InputClass::MouseMove, inst->platform.Now());
+			else if (msg != WM_MOUSEACTIVATE && msg != WM_MOUSEHOVER && msg != WM_MOUSEWHEEL)
+				inst->presenter.inputLatency.Input(InputClass::MouseButton, inst->platform.Now());
+
+			// game expects cursor position in back buffer resolution
+			if (msg != WM_MOUSEWHEEL && msg != WM_MOUSEACTIVATE && inst->IsBackBufferScaled())
+			{
+				int32_t x = (short)LOWORD(lParam);
+				int32_t y = (short)HIWORD(lParam);
+				auto rect = inst->presentRectSupported ? inst->PresentRect() : ScaleRect{ 0, 0, inst->windowSizeClient.x, inst->windowSizeClient.y };
+				MapToSource(rect, inst->backBufferSize.x, inst->backBufferSize.y, x, y); // same rect as presented into
+				lParam = MAKELPARAM(x, y);
+			}
 			break;
 		}
 
+		// raw mouse movement, collected for the next frame. Registered for this window by MouseUpdate
+		case WM_INPUT:
+			inst->OnRawInput((HRAWINPUT)lParam);
+			return DefWindowProc(wnd, msg, wParam, lParam); // does the cleanup, the game does not use raw input
+
+		// window frame metrics changed
+		case WM_STYLECHANGED:
+			inst->OnStyleChanged();
+			break;
+
+		case WM_DISPLAYCHANGE:
+			inst->OnDisplayChange();
+			break;
+
+		// Moved to monitor with different DPI. Client size is kept in pixels, only the frame is scaled,
+		// so the back buffer stays the same and no device reset is needed.
+		case WM_GETDPISCALEDSIZE: // per monitor v2 only, size of the suggested rect in WM_DPICHANGED
+		{
+			auto size = (SIZE*)lParam;
+			auto windowSize = inst->GetDpiScaledSize(LOWORD(wParam));
+			size->cx = windowSize.x;
+			size->cy = windowSize.y;
+			return TRUE;
+		}
+
+		case WM_DPICHANGED:
+		{
+			auto suggested = (RECT*)lParam;
+			inst->OnDpiChanged(LOWORD(wParam), { suggested->left, suggested->top });
+			return 0; // game itself does not handle DPI
+		}
+
+		case WM_SETTINGCHANGE:
+			if (wParam == SPI_SETWORKAREA) inst->OnWorkAreaChange();
+			break;
+
 		case WM_STYLECHANGING:
 		{
 			auto styles = (STYLESTRUCT*)lParam;
@@ -493,315 +604,481 @@ LRESULT APIENTRY WindowedMode::WindowProc(HWND wnd, UINT msg, WPARAM wParam, LPA
 		case WM_SIZING:
 		{
 			auto wndRect = (RECT*)lParam;
-			auto size = inst->ClientFromSize({
-				wndRect->right - wndRect->left,
-				wndRect->bottom - wndRect->top
-			});
-
-			// minimal game resolution
-			size.x = max(size.x, Resolution_Min.x);
-			size.y = max(size.y, Resolution_Min.y);
-
-			// snap to known aspect ratios
-			auto idx = FindAspectRatio(size, 0.02f);
-			if (idx != -1)
-			{
-				auto currAspect = float(size.x) / size.y;
-
-				switch(wParam)
-				{
-					case WMSZ_LEFT:
-					case WMSZ_RIGHT:
-						size.x = LONG(size.y * AspectRatios[idx].ratio);
-						break;
-
-					case WMSZ_TOP:
-					case WMSZ_BOTTOM:
-						size.y = LONG(size.x / AspectRatios[idx].ratio);
-						break;
-
-					default: // sizing both X and Y
-					{
-						if (currAspect < AspectRatios[idx].ratio)
-							size.x = LONG(size.y * AspectRatios[idx].ratio);
-						else
-							size.y = LONG(size.x / AspectRatios[idx].ratio);
-					}
-				}
-			}
-
-			// update window title immediately
-			inst->windowSizeClient.x = size.x;
-			inst->windowSizeClient.y = size.y;
-			inst->WindowUpdateTitle();
-
-			// apply modified window size
-			size = inst->SizeFromClient(size);
-			if (wParam == WMSZ_LEFT || wParam == WMSZ_TOPLEFT || wParam == WMSZ_BOTTOMLEFT) wndRect->left = wndRect->right - size.x;
-			if (wParam == WMSZ_RIGHT || wParam == WMSZ_TOPRIGHT || wParam == WMSZ_BOTTOMRIGHT) wndRect->right = wndRect->left + size.x;
-			if (wParam == WMSZ_TOP || wParam == WMSZ_TOPLEFT || wParam == WMSZ_TOPRIGHT) wndRect->top = wndRect->bottom - size.y;
-			if (wParam == WMSZ_BOTTOM || wParam == WMSZ_BOTTOMLEFT || wParam == WMSZ_BOTTOMRIGHT) wndRect->bottom = wndRect->top + size.y;
+			PlatformRect rect = { wndRect->left, wndRect->top, wndRect->right, wndRect->bottom };
+			inst->OnSizing((uint32_t)wParam, rect);
+			*wndRect = { rect.left, rect.top, rect.right, rect.bottom };
 
 			return DefWindowProc(wnd, msg, wParam, lParam);
 		}
 
 		case WM_EXITSIZEMOVE:
-			inst->WindowCalculateGeometry(false, true);
+			inst->OnExitSizeMove();
 
 		// minimize, maximize, restore
 		case WM_SIZE:
-			if (wParam != SIZE_MINIMIZED && wParam != SIZE_MAXHIDE) // prevent game from updating resolution for minimized window
-				CallWindowProc(inst->oriWindowProc, wnd, msg, wParam, lParam); // inform the game
+			if (msg == WM_SIZE && (wParam == SIZE_MINIMIZED || wParam == SIZE_RESTORED || wParam == SIZE_MAXIMIZED))
+				inst->presenter.focusThrottle.OnMinimize(wParam == SIZE_MINIMIZED);
+
+			if (msg == WM_SIZE)
+				inst->ForwardSize((uint32_t)wParam, { LOWORD(lParam), HIWORD(lParam) }); // inform the game
+			else if (wParam != SIZE_MINIMIZED && wParam != SIZE_MAXHIDE)
+				inst->platform.ForwardMessage(msg, wParam, lParam);
 			return DefWindowProc(wnd, msg, wParam, lParam); // call default as otherwise maximization will not work correctly on later Windows versions
 
+		// commands queued since the last one
+		case WM_WINDOWEDMODE_COMMANDS:
+			inst->DrainCommands();
+			return S_OK;
+
+		// waiting for the window size to settle
+		case WM_TIMER:
+			if (inst->OnTimer(wParam))
+				return S_OK;
+			break;
+
 		// position or size changed
 		case WM_WINDOWPOSCHANGED:
 		{
-			if (inst->windowUpdating || IsIconic(wnd)) break; // minimized
-
-			bool updated = false;
 			auto info = (WINDOWPOS*)lParam;
+			inst->OnWindowPosChanged({ info->x, info->y }, { info->cx, info->cy }, info->flags);
+			break;
+		}
+	}
 
-			// correct modern Windows styles invisible border
-			RECT padding = inst->GetFrameSize(true);
-			POINT pos = { info->x + padding.left, info->y + padding.top };
-			if ((info->flags & SWP_NOMOVE) == 0)
-			{
-				if (pos.x != inst->windowPos.x || pos.y != inst->windowPos.y)
-				{
-					inst->windowPos = pos;
-					updated = true;
-				}
-			}
+	return inst->platform.ForwardMessage(msg, wParam, lParam);
+}
 
-			if ((info->flags & SWP_NOSIZE) == 0)
-			{
-				if (info->cx != inst->windowSize.x || info->cy != inst->windowSize.y)
-				{
-					inst->windowSize = { info->cx, info->cy };
-					updated = true;
-				}
-			}
+template <class Traits>
+void WindowedMode::ApplyGameResolution()
+{
+	auto& rs = GetRsGlobal<Traits>();
+	rs.ps->fullScreen = false;
+	rs.ps->window = window;
+	rs.MaximumWidth = backBufferSize.x;
+	rs.MaximumHeight = backBufferSize.y;
+	if constexpr (Traits::Title != GTA_SA)
+	{
+		rs.screenWidth = backBufferSize.x;
+		rs.screenHeight = backBufferSize.y;
+	}
 
-			if (updated)
-			{
-				inst->windowSizeClient = inst->ClientFromSize(inst->windowSize);
-				if (inst->windowMode != WindowMode::Fullscreen && !IsZoomed(wnd))
-				{
-					inst->windowPosWindowed = inst->windowPos;
-					inst->windowSizeWindowed = inst->windowSizeClient;
-				}
-				inst->WindowCalculateGeometry();
-				inst->WindowUpdateTitle();
-				inst->SaveConfig();
-			}
+	auto& params = *(typename Traits::PresentParams*)Traits::D3dPresentParams;
+	params.Windowed = TRUE;
+	params.hDeviceWindow = window;
+	params.BackBufferWidth = backBufferSize.x;
+	params.BackBufferHeight = backBufferSize.y;
+	params.BackBufferFormat = Traits::D3D9 ? D3DFMT_A8R8G8B8 : D3DFMT_X8R8G8B8;
+	ApplySwapEffect<Traits>();
+	params.FullScreen_PresentationInterval = D3DPRESENT_INTERVAL_DEFAULT;
+	params.FullScreen_RefreshRateInHz = 0;
 
-			break;
+	// write the resolution into video display modes list
+	auto videoModes = *(DisplayMode**)Traits::RwVideoModes;
+	if (videoModes)
+	{
+		// backup display modes infos before making any changes
+		static std::vector<DisplayMode> videoModesBackup;
+		if (videoModesBackup.empty())
+		{
+			auto count = ((DWORD(*)())Traits::RwEngineGetNumVideoModes)();
+			videoModesBackup.resize(count);
+			memcpy(videoModesBackup.data(), videoModes, count * sizeof(DisplayMode));
 		}
-	}
 
-	return CallWindowProc(inst->oriWindowProc, wnd, msg, wParam, lParam);
+		static int prevVideoMode = -1;
+		int currVideoMode = ((DWORD(*)())Traits::RwEngineGetCurrentVideoMode)();
+	
+		// restore previous display mode info to its original state
+		if (prevVideoMode != -1 && currVideoMode != prevVideoMode) videoModes[prevVideoMode] = videoModesBackup[prevVideoMode];
+		prevVideoMode = currVideoMode;
+
+		// write modified resolution into current display mode info
+		auto& mode = videoModes[currVideoMode];
+		mode.width = backBufferSize.x;
+		mode.height = backBufferSize.y;
+		mode.format = params.BackBufferFormat;
+		mode.refreshRate = params.FullScreen_RefreshRateInHz;
+		mode.flags &= ~1; // clear fullscreen flag
+	}
 }
 
-POINT WindowedMode::SizeFromClient(POINT clientSize) const
+template <class Traits>
+void WindowedMode::ApplySwapEffect()
 {
-	auto frame = GetFrameSize();
-	clientSize.x += frame.left + frame.right;
-	clientSize.y += frame.top + frame.bottom;
-	return clientSize;
+	// Present into destination rect is only allowed with the copy swap effect, which can't be multisampled
+	auto& params = *(typename Traits::PresentParams*)Traits::D3dPresentParams;
+	params.SwapEffect = params.MultiSampleType == D3DMULTISAMPLE_NONE ? D3DSWAPEFFECT_COPY : D3DSWAPEFFECT_DISCARD;
 }
 
-POINT WindowedMode::ClientFromSize(POINT windowSize) const
+template <class Traits>
+void WindowedMode::UpdatePresentRectSupport()
 {
-	auto frame = GetFrameSize();
-	windowSize.x -= frame.left + frame.right;
-	windowSize.y -= frame.top + frame.bottom;
-	return windowSize;
+	auto& params = *(typename Traits::PresentParams*)Traits::D3dPresentParams;
+	presentRectSupported = params.SwapEffect == D3DSWAPEFFECT_COPY;
 }
 
-RECT WindowedMode::GetFrameSize(bool padOnly) const
+template <class Traits>
+HRESULT WindowedMode::D3dPresentHook(IDirect3DDevice8* self, const RECT* srcRect, const RECT* dstRect, HWND wnd, const RGNDATA* region)
 {
-	RECT frame = { 0 };
+	auto prepare = [](bool summaryUpdated)
+	{
+		inst->MouseUpdate<Traits>();
+
+		if (summaryUpdated && inst->platform.IsWindowThread())
+			inst->WindowUpdateTitle(); // frame time statistics, refreshed once per second
+
+		if (inst->frameTraceDumpRequested.exchange(false))
+			inst->DumpFrameTrace();
+		if (inst->inputLatencyDumpRequested.exchange(false))
+			inst->DumpInputLatency();
+		if (inst->frameStatsDumpRequested.exchange(false))
+			inst->DumpFrameStats();
+	};
 
-	if (padOnly)
+	auto present = [&](const ScaleRect* rect)
 	{
-		RECT base, extended;
-		if (GetWindowRect(window, &base) &&
-			SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS, &extended, sizeof(RECT))))
+		RECT scaledRect;
+		if (rect)
 		{
-			frame.left = extended.left - base.left;
-			frame.top = extended.top - base.top;
-			frame.right = base.right - extended.right;
-			frame.bottom = base.bottom - extended.bottom;
+			scaledRect = { rect->left, rect->top, rect->right, rect->bottom };
+			dstRect = &scaledRect;
 		}
-	}
-	else
+
+		auto startupSpan = inst->StartupBegin("First present");
+		auto result = inst->d3dPresentOri(self, srcRect, dstRect, wnd, region);
+		inst->StartupEnd(startupSpan);
+		return result;
+	};
+
+	// multisampled devices can't present into a rect and are stretched over the whole client area instead
+	bool scale = !dstRect && inst->presentRectSupported;
+	auto result = inst->presenter.Frame(*inst, scale, inst->IsMainMenuVisible<Traits>(), prepare, present);
+
+	if (!inst->startupFinished)
+		inst->FinishStartup();
+
+	return result;
+}
+
+template <class Traits>
+HRESULT WindowedMode::D3dResetHook(IDirect3DDevice8* self, D3DPRESENT_PARAMETERS* parameters)
+{
+	inst->BeforeDeviceReset({ (int32_t)parameters->BackBufferWidth, (int32_t)parameters->BackBufferHeight });
+
+	static bool firstReset = true;
+	auto startupSpan = firstReset ? inst->StartupBegin("First reset") : StartupTimeline::MaxSpans;
+	firstReset = false;
+
+	inst->ApplySwapEffect<Traits>(); // game may have changed multisampling since
+	auto& params = *(typename Traits::PresentParams*)Traits::D3dPresentParams;
+	auto result = inst->d3dResetOri(self, (D3DPRESENT_PARAMETERS*)&params);
+	inst->StartupEnd(startupSpan);
+	inst->presenter.frameStats.Restart(); // time spent resetting is not a frame
+
+	if (SUCCEEDED(result))
 	{
-		AdjustWindowRectEx(&frame, WindowStyle(), false, WindowStyleEx());
-		frame.left *= -1; // offset to thickness
-		frame.top *= -1; // offset to thickness
+		inst->UpdatePresentRectSupport<Traits>();
+		inst->UpdatePostEffect<Traits>();
 	}
 
-	return frame;
+	return result;
 }
 
-bool WindowedMode::IsD3D9() const
+size_t WindowedMode::StartupBegin(const char* name)
 {
-	return gameTitle == GameTitle::GTA_SA;
+	return startupFinished ? StartupTimeline::MaxSpans : startupTimeline.Begin(name, presenter.clock.Now());
 }
 
-HRESULT WindowedMode::D3dPresentHook(IDirect3DDevice8* self, const RECT* srcRect, const RECT* dstRect, HWND wnd, const RGNDATA* region)
+void WindowedMode::StartupEnd(size_t span)
 {
-	inst->MouseUpdate();
+	startupTimeline.End(span, presenter.clock.Now());
+}
 
-	if (inst->fpsCounter.update())
-		inst->WindowUpdateTitle();
+void WindowedMode::StartupMark(const char* name)
+{
+	if (!startupFinished) startupTimeline.Mark(name, presenter.clock.Now());
+}
 
-	auto result = inst->d3dPresentOri(self, srcRect, dstRect, wnd, region);
+void WindowedMode::FinishStartup()
+{
+	startupFinished = true;
+	ReportStartup();
 
-	// limit framerate in main menu
-	if (inst->menuFrameRateLimit > 0 && inst->IsMainMenuVisible())
-	{
-		static DWORD prevTime = 0;
-		DWORD currTime = timeGetTime();
-	
-		while (true)
-		{
-			DWORD delta = currTime - prevTime;
+#ifdef DEBUG
+	DumpStartupTimeline(); // release builds write it on request only
+#endif
+}
 
-			if (delta >= (1000 / (DWORD)inst->menuFrameRateLimit))
-				break;
+void WindowedMode::DumpStartupTimeline() const
+{
+	if (!startupFinished)
+		return;
 
-			Sleep(1);
-			currTime = timeGetTime();
-		}
-		prevTime = currTime;
-	}
+	FILE* file;
+	if (fopen_s(&file, rsc_ProductName ".startup.json", "w"))
+		return;
 
-	return result;
+	startupTimeline.WriteJson(file);
+	fclose(file);
 }
 
-HRESULT WindowedMode::D3dResetHook(IDirect3DDevice8* self, D3DPRESENT_PARAMETERS* parameters)
+void WindowedMode::DumpFrameTrace() const
 {
-	if (parameters->BackBufferWidth == inst->windowSizeClient.x && parameters->BackBufferHeight == inst->windowSizeClient.y)
-	{
-		inst->WindowCalculateGeometry(); // update presentation params
-	}
-	else // resolution changed
+	FILE* file;
+	if (fopen_s(&file, rsc_ProductName ".trace.json", "w"))
+		return;
+
+	presenter.frameTrace.WriteJson(file);
+	fclose(file);
+}
+
+void WindowedMode::DumpInputLatency() const
+{
+	FILE* file;
+	if (fopen_s(&file, rsc_ProductName ".latency.txt", "w"))
+		return;
+
+	auto& inputLatency = presenter.inputLatency;
+	fprintf(file, "input to present latency (ms)\n");
+	for (int type = 0; type < (int)InputClass::Count; type++)
 	{
-		inst->WindowResize({ (LONG)parameters->BackBufferWidth, (LONG)parameters->BackBufferHeight });
+		auto summary = inputLatency.Summarize((InputClass)type);
+		fprintf(file, "%-13s events: %-8llu p50: %6.2f p95: %6.2f p99: %6.2f\n",
+			InputLatencyTracker::GetName((InputClass)type), summary.events, summary.p50 / 1e6, summary.p95 / 1e6, summary.p99 / 1e6);
 	}
+	fprintf(file, "not measured (too many events in one frame): %u\n", inputLatency.dropped);
+	fclose(file);
+}
 
-	auto result = inst->d3dResetOri(self, inst->d3dPresentParams8);
+void WindowedMode::DumpFrameStats() const
+{
+	FILE* file;
+	if (fopen_s(&file, rsc_ProductName ".frametimes.txt", "w"))
+		return;
 
-	if (SUCCEEDED(result))
-		inst->UpdatePostEffect();
+	auto& session = presenter.frameStats.Session();
+	fprintf(file, "frame times since start (ms)\n");
+	fprintf(file, "frames: %llu p50: %.2f p90: %.2f p99: %.2f p99.9: %.2f\n", session.GetCount(),
+		session.Percentile(0.5) / 1e6, session.Percentile(0.9) / 1e6, session.Percentile(0.99) / 1e6, session.Percentile(0.999) / 1e6);
 
-	return result;
+	auto& last = presenter.frameSummary;
+	fprintf(file, "last second: %u fps avg: %.2f p50: %.2f p99: %.2f p99.9: %.2f max: %.2f\n", last.Fps(),
+		last.avg / 1e6, last.p50 / 1e6, last.p99 / 1e6, last.p999 / 1e6, last.max / 1e6);
+	fclose(file);
+}
+
+void WindowedMode::DumpMessageTrace() const
+{
+	FILE* file;
+	if (fopen_s(&file, rsc_ProductName ".messages.bin", "wb"))
+		return;
+
+	messageTrace.Save(file);
+	fclose(file);
 }
 
 bool WindowedMode::IsMainMenuVisible() const
 {
-	switch(gameTitle)
-	{
-		case GTA_3:
-		{
-			auto mgr = (CMenuManager3*)frontEndMenuManager;
-			return mgr->m_bMenuActive;
-		}
+	return ForGame([this](auto traits) { return IsMainMenuVisible<decltype(traits)>(); });
+}
 
-		case GTA_VC:
-		{
-			auto mgr = (CMenuManagerVC*)frontEndMenuManager;
-			return mgr->m_bMenuActive;
-		}
-		
-		case GTA_SA:
-		{
-			auto mgr = (CMenuManagerSA*)frontEndMenuManager;
-			return mgr->m_bMenuActive;
-		}
+template <class Traits>
+bool WindowedMode::IsMainMenuVisible() const
+{
+	auto mgr = (const typename Traits::MenuManager*)Traits::FrontEndMenuManager;
+	return mgr->m_bMenuActive;
+}
 
-		default:
-			return false;
-	}
+void WindowedMode::SwitchMainMenu(bool show)
+{
+	ForGame([this, show](auto traits) { SwitchMainMenu<decltype(traits)>(show); });
 }
 
+template <class Traits>
 void WindowedMode::SwitchMainMenu(bool show)
 {
-	switch(gameTitle)
+	if constexpr (Traits::Title == GTA_3)
 	{
-		case GTA_3:
-			if (show)
-				injector::cstd<void()>::call(0x488770); // CMenuManager::RequestFrontEndStartUp()
-			else
-				injector::cstd<void()>::call(0x488750); // CMenuManager::RequestFrontEndShutDown()
-			break;
+		if (show)
+			injector::cstd<void()>::call(0x488770); // CMenuManager::RequestFrontEndStartUp()
+		else
+			injector::cstd<void()>::call(0x488750); // CMenuManager::RequestFrontEndShutDown()
+	}
+	else
+	{
+		auto mgr = (typename Traits::MenuManager*)Traits::FrontEndMenuManager;
+		if (show == mgr->m_bMenuActive) return; // already done
 
-		case GTA_VC:
+		if constexpr (Traits::Title == GTA_VC)
 		{
-			auto mgr = (CMenuManagerVC*)frontEndMenuManager;
-			if (show == mgr->m_bMenuActive) break; // already done
-			
 			mgr->m_bStartUpFrontEndRequested = show;
 			mgr->m_bShutDownFrontEndRequested = !show;
-			break;
 		}
-		
-		case GTA_SA:
+		else
 		{
-			auto mgr = (CMenuManagerSA*)frontEndMenuManager;
-			if (show == mgr->m_bMenuActive) break; // already done
-
 			mgr->m_bActivateMenuNextFrame = show;
 			mgr->m_bDontDrawFrontEnd = !show;
-			break;
 		}
 	}
 }
 
+GameState WindowedMode::GetGameState() const
+{
+	return ForGame([](auto traits) { return *(GameState*)decltype(traits)::GameState; });
+}
+
 void WindowedMode::MouseUpdate(bool force)
 {
-	return;
+	ForGame([this, force](auto traits) { MouseUpdate<decltype(traits)>(force); });
 }
 
+template <class Traits>
+void WindowedMode::MouseUpdate(bool force)
+{
+	if (!rawMouse || !window)
+		return;
+
+	// game creates its DirectInput mouse later than the window
+	auto platform = GetRsGlobal<Traits>().ps;
+	if (!diGetDeviceStateOri && platform && platform->diMouse)
+	{
+		auto vTable = *(uintptr_t**)platform->diMouse;
+		diAcquireOri = reinterpret_cast<decltype(diAcquireOri)>(vTable[7]);
+		diGetDeviceStateOri = reinterpret_cast<decltype(diGetDeviceStateOri)>(vTable[9]);
+
+		const PatchOp patches[] =
+		{
+			PatchOp::Write((uintptr_t)&vTable[7], (uintptr_t)&DiAcquireHook<Traits>),
+			PatchOp::Write((uintptr_t)&vTable[9], (uintptr_t)&DiGetDeviceStateHook<Traits>),
+		};
+		ApplyPatches(patches);
+	}
+
+	// registration replaces the one of any other window, so it's renewed after each Acquire of the game's mouse
+	if (!rawMouseRegistered)
+	{
+		RAWINPUTDEVICE device = { 0x01, 0x02, 0, window }; // generic desktop, mouse. Legacy messages stay enabled for the cursor
+		rawMouseRegistered = RegisterRawInputDevices(&device, 1, sizeof(device));
+		if (!rawMouseRegistered)
+		{
+			rawMouse = false; // keep DirectInput movement
+			return;
+		}
+	}
+
+	// movement since previous frame, kept until the game reads it
+	auto delta = rawMouseMotion.Sample();
+	rawMouseFrame.x += delta.x;
+	rawMouseFrame.y += delta.y;
+	rawMouseFrame.wheel += delta.wheel;
+	rawMouseFrame.events += delta.events;
+}
+
+void WindowedMode::OnRawInput(HRAWINPUT input)
+{
+	RAWINPUT raw;
+	UINT size = sizeof(raw);
+	if (GetRawInputData(input, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1 || raw.header.dwType != RIM_TYPEMOUSE)
+		return;
+
+	auto& mouse = raw.data.mouse;
+	if (mouse.usFlags & MOUSE_MOVE_ABSOLUTE) // tablets, remote desktop
+	{
+		rawMouse = false; // fall back to DirectInput movement
+		return;
+	}
+
+	// buttons 1-5, each with its down flag followed by the up flag
+	for (int button = 0; button < 5; button++)
+	{
+		if (mouse.usButtonFlags & (RI_MOUSE_BUTTON_1_DOWN << (button * 2))) rawMouseButtons |= 1 << button;
+		if (mouse.usButtonFlags & (RI_MOUSE_BUTTON_1_UP << (button * 2))) rawMouseButtons &= ~(1 << button);
+	}
+
+	auto wheel = (mouse.usButtonFlags & RI_MOUSE_WHEEL) ? (short)mouse.usButtonData : 0;
+	rawMouseMotion.Add(mouse.lLastX, mouse.lLastY, wheel);
+	presenter.inputLatency.Input(InputClass::RawMouse, platform.Now());
+}
+
+template <class Traits>
+HRESULT WindowedMode::DiAcquireHook(LPDIRECTINPUTDEVICE8 self)
+{
+	auto result = diAcquireOri(self);
+
+	// DirectInput registered raw mouse input for its own window, take it back on the next frame
+	auto platform = GetRsGlobal<Traits>().ps;
+	if (SUCCEEDED(result) && platform && self == platform->diMouse)
+		inst->rawMouseRegistered = false;
+
+	return result;
+}
+
+template <class Traits>
+HRESULT WindowedMode::DiGetDeviceStateHook(LPDIRECTINPUTDEVICE8 self, DWORD size, LPVOID data)
+{
+	auto result = diGetDeviceStateOri(self, size, data);
+
+	// vtable is shared by all the DirectInput devices
+	auto platform = GetRsGlobal<Traits>().ps;
+	// DirectInput's own values are kept unless WM_INPUT reported something since the previous read
+	if (SUCCEEDED(result) && inst->rawMouse && inst->rawMouseFrame.events && platform && self == platform->diMouse && size >= sizeof(DIMOUSESTATE))
+	{
+		auto state = (DIMOUSESTATE*)data; // DIMOUSESTATE2 starts the same way
+		state->lX = inst->rawMouseFrame.x;
+		state->lY = inst->rawMouseFrame.y;
+		state->lZ = inst->rawMouseFrame.wheel;
+		inst->rawMouseFrame = {};
+	}
+
+	// buttons reach only the window holding the registration
+	if (SUCCEEDED(result) && inst->rawMouse && inst->rawMouseRegistered && platform && self == platform->diMouse && size >= sizeof(DIMOUSESTATE))
+	{
+		auto state = (DIMOUSESTATE2*)data;
+		auto buttons = size >= sizeof(DIMOUSESTATE2) ? 5 : 4;
+		for (int button = 0; button < buttons; button++)
+		{
+			if (inst->rawMouseButtons & (1 << button)) state->rgbButtons[button] = 0x80;
+		}
+	}
+
+	return result;
+}
+
+template <class Traits>
 void WindowedMode::UpdatePostEffect()
 {
-	switch(gameTitle)
+	if constexpr (Traits::Title == GTA_3)
 	{
-		case GameTitle::GTA_3:
-			injector::cstd<void(RwCamera*)>::call(0x50AE40, *(RwCamera**)0x72676C); // CMBlurMotion::BlurOpen(RwCamera*)
-			break;
-			
-		case GameTitle::GTA_VC:
-			injector::cstd<void(RwCamera*)>::call(0x55CE20, *(RwCamera**)0x8100BC); // CMBlurMotion::BlurOpen(RwCamera*)
-			break;
-			
-		case GameTitle::GTA_SA:
+		injector::cstd<void(RwCamera*)>::call(0x50AE40, *(RwCamera**)0x72676C); // CMBlurMotion::BlurOpen(RwCamera*)
+	}
+	else if constexpr (Traits::Title == GTA_VC)
+	{
+		injector::cstd<void(RwCamera*)>::call(0x55CE20, *(RwCamera**)0x8100BC); // CMBlurMotion::BlurOpen(RwCamera*)
+	}
+	else
+	{
+		POINT oriSize;
+		auto cam = *(RwCamera**)0xC1703C; // Scene.m_pRwCamera
+		if (cam)
 		{
-			POINT oriSize;
-			auto cam = *(RwCamera**)0xC1703C; // Scene.m_pRwCamera
-			if (cam)
-			{
-				oriSize = { cam->frameBuffer->nWidth, cam->frameBuffer->nHeight }; // store
-				cam->frameBuffer->nWidth = windowSizeClient.x;
-				cam->frameBuffer->nHeight = windowSizeClient.y;
-			}
+			oriSize = { cam->frameBuffer->nWidth, cam->frameBuffer->nHeight }; // store
+			cam->frameBuffer->nWidth = backBufferSize.x;
+			cam->frameBuffer->nHeight = backBufferSize.y;
+		}
 
-			injector::cstd<void()>::call(0x7043D0); // CPostEffects::SetupBackBufferVertex()
+		injector::cstd<void()>::call(0x7043D0); // CPostEffects::SetupBackBufferVertex()
 
-			if (cam)
-			{
-				cam->frameBuffer->nWidth = oriSize.x; // restore
-				cam->frameBuffer->nHeight = oriSize.y;
-			}
-			break;
+		if (cam)
+		{
+			cam->frameBuffer->nWidth = oriSize.x; // restore
+			cam->frameBuffer->nHeight = oriSize.y;
 		}
 	}
 
-	UpdateWidescreenFix();
+	UpdateWidescreenFix<Traits>();
 }
 
+template <class Traits>
 void WindowedMode::UpdateWidescreenFix()
 {
 	static bool initialized = false;
@@ -810,21 +1087,7 @@ void WindowedMode::UpdateWidescreenFix()
 
 	if (!initialized)
 	{
-		switch(gameTitle)
-		{
-			case GameTitle::GTA_3:
-				widescreenFix = GetModuleHandle("GTA3.WidescreenFix.asi");
-				break;
-			
-			case GameTitle::GTA_VC:
-				widescreenFix = GetModuleHandle("GTAVC.WidescreenFix.asi");
-				break;
-			
-			case GameTitle::GTA_SA:
-				widescreenFix = GetModuleHandle("GTASA.WidescreenFix.asi");
-				break;
-		}
-
+		widescreenFix = GetModuleHandle(Traits::WidescreenFix);
 		if (widescreenFix)
 			updateFunc = GetProcAddress(widescreenFix, "UpdateVars");
 
@@ -1,113 +1,236 @@
 #pragma once
 #include "misc.h"
+#include "WindowController.h"
+#include "FramePresenter.h"
+#include "DeviceVTable.h"
+#include "TitleUpdater.h"
+#include "StartupTimeline.h"
+#include "MouseAccumulator.h"
 #include <unordered_map>
+#include <algorithm>
 
-class WindowedMode
+class WindowedMode : public WindowController
 {
 public:
-	static constexpr POINT Resolution_Default = { 640, 448 }; // default GTA's PS2 resolution
-	static constexpr POINT Resolution_Min = { Resolution_Default.x / 4, Resolution_Default.y / 4 };
-
 	enum GameTitle : BYTE { GTA_3, GTA_VC, GTA_SA };
 
+	static void Arm(); // called from DllMain, rest of initialization waits for the game creating its window unless it exists already
+	static bool Init(); // detects game version and patches it, false if not supported
+	static bool InitBySignature(); // executable of unknown version with code of a supported one
+	static void ReportStartup();
+
 	static void InitGta3();
 	static void InitGtaVC();
 	static void InitGtaSA();
 
-	// game internals
+	static inline uintptr_t* createWindowImport = nullptr; // game's import table entry of CreateWindowExA
+	static inline decltype(&CreateWindowExA) createWindowOri = nullptr;
+	static HWND __stdcall CreateWindowHook(DWORD dwExStyle, LPCSTR lpClassName, LPCSTR lpWindowName, DWORD dwStyle, int X, int Y, int nWidth, int nHeight, HWND hWndParent, HMENU hMenu, HINSTANCE hInstance, LPVOID lpParam);
+
+	// game internals, addresses come from the game traits below
 	const GameTitle gameTitle;
-	GameState& gameState;
-	union{ RsGlobalType* rsGlobal; RsGlobalTypeSA* rsGlobalSA; }; // different in SA
-	WNDPROC oriWindowProc;
-	IDirect3DDevice8* &d3dDevice;
-	union{ D3DPRESENT_PARAMETERS* d3dPresentParams8; D3DPRESENT_PARAMETERS_D3D9* d3dPresentParams9; }; // DirectX 8 or 9
-	DisplayMode** rwVideoModes; // array
-	DWORD (*RwEngineGetNumVideoModes)();
-	DWORD (*RwEngineGetCurrentVideoMode)();
-	uintptr_t frontEndMenuManager;
-
-	// constructor taking addresses for specific game version
-	WindowedMode(
-		GameTitle gameTitle,
-		uintptr_t gameState,
-		uintptr_t rsGlobal,
-		uintptr_t d3dDevice,
-		uintptr_t d3dPresentParams,
-		uintptr_t rwVideoModes,
-		uintptr_t RwEngineGetNumVideoModes,
-		uintptr_t RwEngineGetCurrentVideoMode,
-		uintptr_t frontEndMenuManager
-	);
+	WNDPROC oriWindowProc = nullptr;
+
+	WindowedMode(GameTitle gameTitle);
+	template <class Traits> static WindowedMode* Create();
+
+	template <class Traits> static typename Traits::RsGlobal& GetRsGlobal();
+	GameState GetGameState() const;
+
+	// runs func with traits object of current game, for code outside of the specialized hot paths
+	template <class Func> decltype(auto) ForGame(Func&& func) const;
 
 	static HWND __stdcall InitWindow(DWORD dwExStyle, LPCSTR lpClassName, LPCSTR lpWindowName, DWORD dwStyle, int X, int Y, int nWidth, int nHeight, HWND hWndParent, HMENU hMenu, HINSTANCE hInstance, LPVOID lpParam);
-	void InitD3dDevice(); // instal hooks
+	template <class Traits> void InitD3dDevice(); // instal hooks
 
 	// config file
 	CIniReader config;
 	void InitConfig(); // create default ini file
 	bool LoadConfig(); // returns true if maximized
-	void SaveConfig();
+	void SaveConfig() override;
 
 	// game window
-	struct AspectRatioInfo { const char* name; float ratio; };
-	static const AspectRatioInfo AspectRatios[];
-	static int FindAspectRatio(POINT resolution, float treshold = 0.007f);
-
-	enum WindowMode : BYTE
-	{
-		Windowed = 1, WindowedBorderless, Fullscreen,
-		Min = Windowed,
-		Max = Fullscreen
-	};
-	
 	HWND window = 0;
-	bool windowUpdating = false; // update in progress
-	WindowMode windowMode = WindowMode::Windowed;
 	HICON windowIcon = NULL;
 	char windowClassName[64];
-	char windowTitle[64];
-	// current window geometry
-	POINT windowPos = {};
-	POINT windowSize = {};
-	POINT windowSizeClient = {};
-	// last properties of windowed mode
-	POINT windowPosWindowed = { -1, -1 };
-	POINT windowSizeWindowed = Resolution_Default;
-
-	void WindowCalculateGeometry(bool center = false, bool resizeWindow = false);
-	void WindowResize(POINT resolution);
+	TitleText windowTitle;
+	TitleUpdater titleUpdater{
+		[](void* window, const char* text) { SetWindowText(*(HWND*)window, text); },
+		&window,
+		[](std::thread& thread) { SetThreadPriority(thread.native_handle(), THREAD_PRIORITY_LOWEST); }
+	};
+	Win32GeometrySource win32Geometry{ window };
+	Win32WindowPlatform win32Platform{ window, oriWindowProc }; // game's window procedure is reached through the platform too
+
 	void WindowModeCycle();
-	DWORD WindowStyle() const;
-	DWORD WindowStyleEx() const;
-	void WindowUpdateTitle();
-	static LRESULT APIENTRY WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-	POINT SizeFromClient(POINT clientSize) const;
-	POINT ClientFromSize(POINT windowSize) const;
-	RECT GetFrameSize(bool paddOnly = false) const; // size of window frame and extra padding/shadow introduced in later versions of Windows
-	
+	uint32_t WindowStyle() const override;
+	uint32_t WindowStyleEx() const override;
+	void WindowUpdateTitle(const PlatformPoint* clientSize = nullptr) override; // current client size if not specified
+	void ApplyBackBuffer() override;
+	static LRESULT APIENTRY WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam); // records the message and handles it
+	static LRESULT HandleMessage(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
 	// DirectX 3D related stuff
-	bool IsD3D9() const;
 
-	HRESULT static __stdcall D3dPresentHook(IDirect3DDevice8* self, const RECT* srcRect, const RECT* dstRect, HWND wnd, const RGNDATA* region);
-	decltype(D3dPresentHook)* d3dPresentOri;
+	using PresentFunc = HRESULT (__stdcall *)(IDirect3DDevice8* self, const RECT* srcRect, const RECT* dstRect, HWND wnd, const RGNDATA* region);
+	template <class Traits> static HRESULT __stdcall D3dPresentHook(IDirect3DDevice8* self, const RECT* srcRect, const RECT* dstRect, HWND wnd, const RGNDATA* region);
+	PresentFunc d3dPresentOri;
+
+	using ResetFunc = HRESULT (__stdcall *)(IDirect3DDevice8* self, D3DPRESENT_PARAMETERS* parameters);
+	template <class Traits> static HRESULT __stdcall D3dResetHook(IDirect3DDevice8* self, D3DPRESENT_PARAMETERS* parameters);
+	ResetFunc d3dResetOri;
 
-	HRESULT static __stdcall D3dResetHook(IDirect3DDevice8* self, D3DPRESENT_PARAMETERS* parameters);
-	decltype(D3dResetHook)* d3dResetOri;
+	template <class Traits> void ApplyGameResolution(); // back buffer size into game's globals and presentation params
+	template <class Traits> void ApplySwapEffect(); // copy unless multisampled, so Present can scale into a rect
+	template <class Traits> void UpdatePresentRectSupport(); // after device creation or reset
+	std::atomic<bool> presentRectSupported = false; // device uses copy swap effect
 
 	// other
-	FpsCounter fpsCounter;
+	FramePresenter<QpcClock> presenter; // statistics, throttling and limiting around each present
+	void DumpFrameTrace() const; // render thread only, the ring is written by each present
+	std::atomic<bool> frameTraceDumpRequested = false; // set by the hotkey, written out by the next present
+	void DumpInputLatency() const; // render thread only, tracker is not synchronized
+	std::atomic<bool> inputLatencyDumpRequested = false; // set by the hotkey, written out by the next present
+	void DumpFrameStats() const; // render thread only, session histogram is not synchronized
+	std::atomic<bool> frameStatsDumpRequested = false; // set by the hotkey, written out by the next present
+
+	// window message recording
+	MessageTrace messageTrace;
+	void DumpMessageTrace() const;
+
+	// startup profiling, recorded until the first present
+	std::atomic<bool> startupFinished = false; // timeline is not written to anymore
+	size_t startupDeviceSpan = StartupTimeline::MaxSpans;
+	size_t StartupBegin(const char* name); // invalid index once finished
+	void StartupEnd(size_t span);
+	void StartupMark(const char* name) override;
+	void FinishStartup(); // reports to debug output, writes timeline file in debug builds
+	void DumpStartupTimeline() const;
 	bool autoPause = true;
 	bool autoResume = true;
 	bool autoPauseExecuted = false;
-	int menuFrameRateLimit = 30;
 
 	bool IsMainMenuVisible() const;
+	template <class Traits> bool IsMainMenuVisible() const;
 	void SwitchMainMenu(bool show);
+	template <class Traits> void SwitchMainMenu(bool show);
 	
 	void MouseUpdate(bool force = false);
-	void UpdatePostEffect();
-	void UpdateWidescreenFix();
+	template <class Traits> void MouseUpdate(bool force = false);
+
+	// raw input mouse, replaces movement reported by game's DirectInput mouse whenever WM_INPUT delivered some
+	bool rawMouse = true;
+	bool rawMouseRegistered = false; // only one window of the process receives it, DirectInput takes it back on Acquire
+	uint8_t rawMouseButtons = 0; // held buttons, DirectInput stops seeing them while the registration is ours
+	MouseAccumulator rawMouseMotion; // filled by WM_INPUT
+	MouseAccumulator::Delta rawMouseFrame = {}; // sampled each frame, handed to the game on its next read
+	void OnRawInput(HRAWINPUT input);
+	static inline HRESULT (__stdcall *diAcquireOri)(LPDIRECTINPUTDEVICE8 self) = nullptr;
+	static inline HRESULT (__stdcall *diGetDeviceStateOri)(LPDIRECTINPUTDEVICE8 self, DWORD size, LPVOID data) = nullptr;
+	template <class Traits> static HRESULT __stdcall DiAcquireHook(LPDIRECTINPUTDEVICE8 self);
+	template <class Traits> static HRESULT __stdcall DiGetDeviceStateHook(LPDIRECTINPUTDEVICE8 self, DWORD size, LPVOID data);
+	template <class Traits> void UpdatePostEffect();
+	template <class Traits> void UpdateWidescreenFix();
 };
 
+// Compile time description of each supported game version.
+// Code specialized for these has no runtime game checks and accesses game structures with their own types.
+struct Gta3Traits
+{
+	static constexpr auto Title = WindowedMode::GTA_3;
+	static constexpr bool D3D9 = false;
+	static constexpr const char* WidescreenFix = "GTA3.WidescreenFix.asi";
+	static constexpr const char* WindowClass = "Grand theft auto 3";
+
+	using RsGlobal = RsGlobalType;
+	using PresentParams = D3DPRESENT_PARAMETERS;
+	using MenuManager = CMenuManager3;
+
+	static constexpr uintptr_t CreateWindowCall = 0x580F20; // call of CreateWindowExA through the import table, also identifies the code layout
+	static constexpr uintptr_t GameState = 0x8F5838;
+	static constexpr uintptr_t RsGlobalAddress = 0x8F4360;
+	static constexpr uintptr_t D3dDevice = 0x662EF0;
+	static constexpr uintptr_t D3dPresentParams = 0x943010;
+	static constexpr uintptr_t RwVideoModes = 0x662F18;
+	static constexpr uintptr_t RwEngineGetNumVideoModes = 0x5A0ED0;
+	static constexpr uintptr_t RwEngineGetCurrentVideoMode = 0x5A0F30;
+	static constexpr uintptr_t FrontEndMenuManager = 0x8F59D8;
+
+	static_assert(offsetof(MenuManager, m_bMenuActive) == 0x111, "CMenuManager3 layout");
+	static_assert(sizeof(void*) != 4 || offsetof(RsGlobal, ps) == 0x1C, "RsGlobalType layout");
+};
+
+struct GtaVCTraits
+{
+	static constexpr auto Title = WindowedMode::GTA_VC;
+	static constexpr bool D3D9 = false;
+	static constexpr const char* WidescreenFix = "GTAVC.WidescreenFix.asi";
+	static constexpr const char* WindowClass = "Grand theft auto 3";
+
+	using RsGlobal = RsGlobalType;
+	using PresentParams = D3DPRESENT_PARAMETERS;
+	using MenuManager = CMenuManagerVC;
+
+	static constexpr uintptr_t CreateWindowCall = 0x5FFC75; // call of CreateWindowExA through the import table, also identifies the code layout
+	static constexpr uintptr_t GameState = 0x9B5F08;
+	static constexpr uintptr_t RsGlobalAddress = 0x9B48D8;
+	static constexpr uintptr_t D3dDevice = 0x7897A8;
+	static constexpr uintptr_t D3dPresentParams = 0xA0FD04;
+	static constexpr uintptr_t RwVideoModes = 0x7897D0;
+	static constexpr uintptr_t RwEngineGetNumVideoModes = 0x642B40;
+	static constexpr uintptr_t RwEngineGetCurrentVideoMode = 0x642BA0;
+	static constexpr uintptr_t FrontEndMenuManager = 0x869630;
+
+	static_assert(offsetof(MenuManager, m_bShutDownFrontEndRequested) == 0x11, "CMenuManagerVC layout");
+	static_assert(offsetof(MenuManager, m_bStartUpFrontEndRequested) == 0x12, "CMenuManagerVC layout");
+	static_assert(offsetof(MenuManager, m_bMenuActive) == 0x38, "CMenuManagerVC layout");
+	static_assert(sizeof(void*) != 4 || offsetof(RsGlobal, ps) == 0x1C, "RsGlobalType layout");
+};
+
+struct GtaSATraits
+{
+	static constexpr auto Title = WindowedMode::GTA_SA;
+	static constexpr bool D3D9 = true;
+	static constexpr const char* WidescreenFix = "GTASA.WidescreenFix.asi";
+	static constexpr const char* WindowClass = "Grand theft auto San Andreas";
+
+	using RsGlobal = RsGlobalTypeSA;
+	using PresentParams = D3DPRESENT_PARAMETERS_D3D9;
+	using MenuManager = CMenuManagerSA;
+
+	static constexpr uintptr_t CreateWindowCall = 0x7455D5; // call of CreateWindowExA through the import table, also identifies the code layout
+	static constexpr uintptr_t GameState = 0xC8D4C0;
+	static constexpr uintptr_t RsGlobalAddress = 0xC17040;
+	static constexpr uintptr_t D3dDevice = 0xC97C28;
+	static constexpr uintptr_t D3dPresentParams = 0xC9C040;
+	static constexpr uintptr_t RwVideoModes = 0xC97C48;
+	static constexpr uintptr_t RwEngineGetNumVideoModes = 0x7F2CC0;
+	static constexpr uintptr_t RwEngineGetCurrentVideoMode = 0x7F2D20;
+	static constexpr uintptr_t FrontEndMenuManager = 0xBA6748;
+
+	static_assert(offsetof(MenuManager, m_bDontDrawFrontEnd) == 0x32, "CMenuManagerSA layout");
+	static_assert(offsetof(MenuManager, m_bActivateMenuNextFrame) == 0x33, "CMenuManagerSA layout");
+	static_assert(offsetof(MenuManager, m_bMenuActive) == 0x5C, "CMenuManagerSA layout");
+	static_assert(sizeof(void*) != 4 || offsetof(RsGlobal, ps) == 0x14, "RsGlobalTypeSA layout");
+};
+
+template <class Traits>
+typename Traits::RsGlobal& WindowedMode::GetRsGlobal()
+{
+	return *(typename Traits::RsGlobal*)Traits::RsGlobalAddress;
+}
+
+template <class Func>
+decltype(auto) WindowedMode::ForGame(Func&& func) const
+{
+	switch (gameTitle)
+	{
+		case GTA_3: return func(Gta3Traits());
+		case GTA_VC: return func(GtaVCTraits());
+		default: return func(GtaSATraits());
+	}
+}
+
 static WindowedMode* inst; // global instance
+static StartupTimeline startupTimeline;
 
@@ -2,70 +2,76 @@
 
 void WindowedMode::InitGta3()
 {
-	inst = new WindowedMode(
-		GameTitle::GTA_3,
-		0x8F5838, // gameState
-		0x8F4360, // rsGlobal
-		0x662EF0, // d3dDevice
-		0x943010, // d3dPresentParams
-		0x662F18, // rwVideoModes
-		0x5A0ED0, // RwEngineGetNumVideoModes
-		0x5A0F30, // RwEngineGetCurrentVideoMode
-		0x8F59D8  // FrontEndMenuManager
-	);
+	inst = WindowedMode::Create<Gta3Traits>();
 
 	// check for ASI loader
-	if (inst->rsGlobal->ps && inst->rsGlobal->ps->window) // app window already created
+	auto& rs = GetRsGlobal<Gta3Traits>();
+	if (rs.ps && rs.ps->window) // app window already created
 		ShowError("ASI Loader is required for correct operation of this plugin!");
 
-	strcpy_s(inst->windowClassName, "Grand theft auto 3");
+	strcpy_s(inst->windowClassName, Gta3Traits::WindowClass);
 	inst->windowIcon = LoadIcon(GetModuleHandle(NULL), MAKEINTRESOURCE(1042));
 
-	// Debug: check if somebody already modified memory we want to hook
-#ifdef DEBUG
-	VerifyMemory("CreateWindow", 0x580EE5, 41, 0x8A005124);
-	VerifyMemory("InitPresentationParams", 0x5B7DA1, 6, 0xB5F575C6);
-	VerifyMemory("InitD3dDevice", 0x5B76B8, 6, 0x941520BC);
-	VerifyMemory("Options>Resolution coloring", 0x047C6B8, 2, 0x654DDEDC);
-	VerifyMemory("Options>Resolution disabling", 0x4882CA, 6, 0x66C92448);
-	VerifyMemory("Options>Resolution hook", 0x487842, 5, 0x07A242DD);
-#endif
-
-	// patch call to CreateWindowExA
-	injector::MakeNOP(0x580F20, 6);
-	injector::MakeCALL(0x580F20, WindowedMode::InitWindow);
+	// check if somebody already modified memory we want to hook
+	static const PatchSite patchSites[] =
+	{
+		{ "CreateWindow", 0x580EE5, 41, 0x8A005124 },
+		{ "InitPresentationParams", 0x5B7DA1, 6, 0xB5F575C6 },
+		{ "InitD3dDevice", 0x5B76B8, 6, 0x941520BC },
+		{ "Options>Resolution coloring", 0x047C6B8, 2, 0x654DDEDC },
+		{ "Options>Resolution disabling", 0x4882CA, 6, 0x66C92448 },
+		{ "Options>Resolution hook", 0x487842, 5, 0x07A242DD },
+	};
+	VerifyMemory(patchSites);
 
 	struct Patch_InitPresentationParams // just before D3D device is created
 	{
-		void operator()(injector::reg_pack& regs)
+		using Regs = HookRegs<HookReg::ebp>;
+
+		void operator()(Regs& regs)
 		{
-			*(DWORD*)(0x943038) = regs.ebp; // original action replaced by the patch
+			*(DWORD*)(0x943038) = regs.Get<HookReg::ebp>(); // original action replaced by the patch
 
-			inst->WindowCalculateGeometry();
+			inst->startupDeviceSpan = inst->StartupBegin("Device creation");
+			inst->BeforeDeviceCreate();
 		}
-	}; injector::MakeInline<Patch_InitPresentationParams>(0x5B7DA1, 0x5B7DA7);
+	};
 
 	struct Path_InitD3dDevice // just after D3D device has been created
 	{
-		void operator()(injector::reg_pack& regs)
+		using Regs = HookRegs<>;
+
+		void operator()(Regs& regs)
 		{
-			*(DWORD*)(0x662F04) = regs.eax; // original action replaced by the patch
+			auto device = regs.Get<HookReg::eax>();
+			*(DWORD*)(0x662F04) = device; // original action replaced by the patch
 
-			if (regs.eax) // succeed
+			if (device) // succeed
 			{
-				inst->InitD3dDevice();
+				inst->InitD3dDevice<Gta3Traits>();
 			}
 		}
-	}; injector::MakeInline<Path_InitD3dDevice>(0x5B76B8);
+	};
 
-	injector::WriteMemory(0x047C6B8, BYTE(0xEB), true); // don't gray out resoluton in options menu after game started
-	injector::MakeNOP(0x4882CA, 6); // don't disable resoluton changes in options menu after game started
 	struct Patch_ChangeResolution // user selected new resolition in option menu
 	{
-		void operator()(injector::reg_pack& regs)
+		using Regs = HookRegs<>;
+
+		void operator()(Regs& regs)
 		{
-			auto mode = *inst->rwVideoModes + regs.eax;
-			inst->WindowResize({ (LONG)mode->width, (LONG)mode->height });
+			auto mode = *(DisplayMode**)Gta3Traits::RwVideoModes + regs.Get<HookReg::eax>();
+			inst->PushCommand({ WindowCommand::Resize, 0, {}, { (int32_t)mode->width, (int32_t)mode->height } });
 		}
-	}; injector::MakeInline<Patch_ChangeResolution>(0x487842);
+	};
+
+	const PatchOp patches[] =
+	{
+		PatchOp::MakeCALL(Gta3Traits::CreateWindowCall, WindowedMode::InitWindow, 6), // patch call to CreateWindowExA
+		PatchOp::MakeJMP(0x5B7DA1, MakeHookThunk<Patch_InitPresentationParams>(0x5B7DA1 + 6), 6),
+		PatchOp::MakeJMP(0x5B76B8, MakeHookThunk<Path_InitD3dDevice>(0x5B76B8 + 5), 5),
+		PatchOp::Write(0x047C6B8, BYTE(0xEB)), // don't gray out resoluton in options menu after game started
+		PatchOp::MakeNOP(0x4882CA, 6), // don't disable resoluton changes in options menu after game started
+		PatchOp::MakeJMP(0x487842, MakeHookThunk<Patch_ChangeResolution>(0x487842 + 5), 5),
+	};
+	ApplyPatches(patches);
 }
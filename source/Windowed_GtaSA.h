@@ -2,57 +2,59 @@
 
 void WindowedMode::InitGtaSA()
 {
-	inst = new WindowedMode(
-		GameTitle::GTA_SA,
-		0xC8D4C0, // gameState
-		0xC17040, // rsGlobal
-		0xC97C28, // d3dDevice
-		0xC9C040, // d3dPresentParams
-		0xC97C48, // rwVideoModes
-		0x7F2CC0, // RwEngineGetNumVideoModes
-		0x7F2D20, // RwEngineGetCurrentVideoMode
-		0xBA6748  // FrontEndMenuManager
-	);
-
-	strcpy_s(inst->windowClassName, "Grand theft auto San Andreas");
-	inst->windowIcon = LoadIcon(GetModuleHandle(NULL), MAKEINTRESOURCE(100));
-
-	// Debug: check if somebody already modified memory we want to hook
-#ifdef DEBUG
-	VerifyMemory("Device selection", 0x746225, 1, 0x65BFB3B6);
-	VerifyMemory("RsMouseSetPos call", 0x53E9F1, 5, 0x9D112499);
-	VerifyMemory("CreateWindow", 0x7455D5, 6, 0x4A88D8AA);
-	VerifyMemory("InitPresentationParams", 0x7F670A, 6, 0xAB349BBF);
-	VerifyMemory("InitD3dDevice", 0x7F6800, 6, 0xEDAE7102);
-#endif
+	inst = WindowedMode::Create<GtaSATraits>();
 
-	// do not show device selection dialog in case of multiple display monitors
-	injector::WriteMemory(0x746225, BYTE(0xEB), true);
+	// check for ASI loader
+	auto& rs = GetRsGlobal<GtaSATraits>();
+	if (rs.ps && rs.ps->window) // app window already created
+		ShowError("ASI Loader is required for correct operation of this plugin!");
 
-	// disable recentering cursor pos. Frees mouse when window inactive but game not paused
-	injector::MakeNOP(0x53E9F1, 5); // call to RsMouseSetPos
+	strcpy_s(inst->windowClassName, GtaSATraits::WindowClass);
+	inst->windowIcon = LoadIcon(GetModuleHandle(NULL), MAKEINTRESOURCE(100));
 
-	// patch call to CreateWindowExA
-	injector::MakeNOP(0x7455D5, 6);
-	injector::MakeCALL(0x7455D5, WindowedMode::InitWindow);
+	// check if somebody already modified memory we want to hook
+	static const PatchSite patchSites[] =
+	{
+		{ "Device selection", 0x746225, 1, 0x65BFB3B6 },
+		{ "RsMouseSetPos call", 0x53E9F1, 5, 0x9D112499 },
+		{ "CreateWindow", 0x7455D5, 6, 0x4A88D8AA },
+		{ "InitPresentationParams", 0x7F670A, 6, 0xAB349BBF },
+		{ "InitD3dDevice", 0x7F6800, 6, 0xEDAE7102 },
+	};
+	VerifyMemory(patchSites);
 
 	struct Patch_InitPresentationParams // just before D3D device is created
 	{
-		void operator()(injector::reg_pack& regs)
+		using Regs = HookRegs<>;
+
+		void operator()(Regs& regs)
 		{
-			regs.ecx = *(DWORD*)(0xC97C4C); // original action replaced by the patch
+			regs.Get<HookReg::ecx>() = *(DWORD*)(0xC97C4C); // original action replaced by the patch
 
-			inst->WindowCalculateGeometry();
+			inst->startupDeviceSpan = inst->StartupBegin("Device creation");
+			inst->BeforeDeviceCreate();
 		}
-	}; injector::MakeInline<Patch_InitPresentationParams>(0x7F670A, 0x7F6710);
+	};
 
 	struct Path_InitD3dDevice // just after D3D device has been created
 	{
-		void operator()(injector::reg_pack& regs)
+		using Regs = HookRegs<HookReg::ebp>;
+
+		void operator()(Regs& regs)
 		{
-			*(DWORD*)(0xC9808C) = regs.ebp; // original action replaced by the patch
+			*(DWORD*)(0xC9808C) = regs.Get<HookReg::ebp>(); // original action replaced by the patch
 
-			inst->InitD3dDevice();
+			inst->InitD3dDevice<GtaSATraits>();
 		}
-	}; injector::MakeInline<Path_InitD3dDevice>(0x7F6800, 0x7F6806);
+	};
+
+	const PatchOp patches[] =
+	{
+		PatchOp::Write(0x746225, BYTE(0xEB)), // do not show device selection dialog in case of multiple display monitors
+		PatchOp::MakeNOP(0x53E9F1, 5), // call to RsMouseSetPos. Frees mouse when window inactive but game not paused
+		PatchOp::MakeCALL(GtaSATraits::CreateWindowCall, WindowedMode::InitWindow, 6), // patch call to CreateWindowExA
+		PatchOp::MakeJMP(0x7F670A, MakeHookThunk<Patch_InitPresentationParams>(0x7F670A + 6), 6),
+		PatchOp::MakeJMP(0x7F6800, MakeHookThunk<Path_InitD3dDevice>(0x7F6800 + 6), 6),
+	};
+	ApplyPatches(patches);
 }
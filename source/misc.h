@@ -1,46 +1,42 @@
 #pragma once
 #include <stdint.h>
+#include <limits.h>
 #include "d3d8/d3d8.h"
 #include "d3d8/dinput.h"
 #include "IniReader.h"
 #include "injector/injector.hpp"
 #include "injector/assembly.hpp"
 #include "injector/calling.hpp"
-
-class FpsCounter
+#include "GeometryCache.h"
+#include "PatchIntegrity.h"
+#include "SignatureScanner.h"
+#include "PatchTransaction.h"
+#include "HookThunk.h"
+#include "WindowPlatform.h"
+#include <dwmapi.h>
+
+#ifndef WM_GETDPISCALEDSIZE
+#define WM_GETDPISCALEDSIZE 0x02E4 // Windows 10 1703+
+#endif
+
+// monotonic nanosecond clock for FramePacer
+struct QpcClock
 {
-protected:
-	unsigned int fps;
-	unsigned int count;
-	DWORD prevTime;
-
-public:
-	FpsCounter() : fps(30), count(0), prevTime(timeGetTime() / 1000)
-	{
-	}
-
-	bool update()
+	int64_t Now() const
 	{
-		auto currTime = timeGetTime() / 1000;
-		if (prevTime != currTime)
-		{
-			fps = count;
-			prevTime = currTime;
-			count = 1; // this frame is in next period already
-		}
-		else
-			count++;
+		static const int64_t frequency = []{ LARGE_INTEGER freq; QueryPerformanceFrequency(&freq); return freq.QuadPart; }();
 
-		static DWORD prevFps = -1;
-		auto updated = fps != prevFps;
-		prevFps = fps;
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
 
-		return updated;
+		// split to avoid overflow of counter * 10^9
+		return (counter.QuadPart / frequency) * 1000000000 + (counter.QuadPart % frequency) * 1000000000 / frequency;
 	}
 
-	unsigned int get() const
+	void Sleep(int64_t ns) const
 	{
-		return fps;
+		static const auto period = timeBeginPeriod(1); // 1ms scheduler granularity instead of default 15.6ms
+		::Sleep(DWORD(ns / 1000000));
 	}
 };
 
@@ -408,51 +404,323 @@ struct CMenuManagerSA
 	// incomplete
 };
 
-static inline DWORD Crc32(const BYTE* data, size_t size)
+// DPI of the primary monitor at logon, used by DPI unaware APIs
+static inline uint32_t GetSystemDpi()
+{
+	static auto getDpiForSystem = (UINT(WINAPI*)())GetProcAddress(GetModuleHandle("user32.dll"), "GetDpiForSystem"); // Windows 10 1607+
+	if (getDpiForSystem)
+		return getDpiForSystem();
+
+	auto screen = GetDC(NULL);
+	auto dpi = GetDeviceCaps(screen, LOGPIXELSY);
+	ReleaseDC(NULL, screen);
+	return dpi > 0 ? dpi : USER_DEFAULT_SCREEN_DPI;
+}
+
+// Makes window and monitor coordinates real pixels instead of being virtualized and bitmap stretched by DWM.
+// Per monitor v2 (Windows 10 1703+) if possible, older per monitor or system awareness otherwise.
+// Fails harmlessly if the awareness was already set by the game manifest.
+// Under the loader lock shcore.dll is used only if something else loaded it already.
+static inline void EnableDpiAwareness(bool loaderLock = false)
+{
+	auto setAwarenessContext = (BOOL(WINAPI*)(HANDLE))GetProcAddress(GetModuleHandle("user32.dll"), "SetProcessDpiAwarenessContext");
+	if (setAwarenessContext && setAwarenessContext((HANDLE)-4)) // DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2
+		return;
+
+	auto shcore = loaderLock ? GetModuleHandle("shcore.dll") : LoadLibrary("shcore.dll"); // Windows 8.1+
+	auto setAwareness = shcore ? (HRESULT(WINAPI*)(int))GetProcAddress(shcore, "SetProcessDpiAwareness") : nullptr;
+	if (setAwareness && SUCCEEDED(setAwareness(2))) // PROCESS_PER_MONITOR_DPI_AWARE
+		return;
+
+	SetProcessDPIAware();
+}
+
+// window frame metrics read from Win32 API
+class Win32GeometrySource : public GeometrySource
+{
+public:
+	Win32GeometrySource(const HWND& window) : window(window)
+	{
+	}
+
+	GeometryInsets AdjustFrame(uint32_t style, uint32_t exStyle, uint32_t dpi) override
+	{
+		static auto adjustForDpi = (BOOL(WINAPI*)(LPRECT, DWORD, BOOL, DWORD, UINT))GetProcAddress(GetModuleHandle("user32.dll"), "AdjustWindowRectExForDpi"); // Windows 10 1607+
+
+		RECT frame = { 0 };
+		if (adjustForDpi && adjustForDpi(&frame, style, false, exStyle, dpi))
+			return { -frame.left, -frame.top, frame.right, frame.bottom }; // offsets to thickness
+
+		AdjustWindowRectEx(&frame, style, false, exStyle); // for system DPI
+		return ScaleForDpi({ -frame.left, -frame.top, frame.right, frame.bottom }, GetSystemDpi(), dpi);
+	}
+
+	bool QueryPadding(GeometryInsets& padding) override
+	{
+		RECT base, extended;
+		if (!GetWindowRect(window, &base) ||
+			FAILED(DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS, &extended, sizeof(RECT))))
+			return false;
+
+		padding.left = extended.left - base.left;
+		padding.top = extended.top - base.top;
+		padding.right = base.right - extended.right;
+		padding.bottom = base.bottom - extended.bottom;
+		return true;
+	}
+
+	uint32_t QueryDpi() override
+	{
+		static auto getDpiForWindow = (UINT(WINAPI*)(HWND))GetProcAddress(GetModuleHandle("user32.dll"), "GetDpiForWindow"); // Windows 10+
+		auto dpi = (getDpiForWindow && window) ? getDpiForWindow(window) : 0;
+		return dpi ? dpi : GetSystemDpi(); // window is created with system DPI frame
+	}
+
+	const void* QueryMonitor() override
+	{
+		return MonitorFromWindow(window, MONITOR_DEFAULTTONEAREST);
+	}
+
+protected:
+	const HWND& window;
+};
+
+class Win32WindowPlatform : public WindowPlatform
 {
-	DWORD crc = ~0;
-	for (size_t i = 0; i < size; i++)
+public:
+	Win32WindowPlatform(const HWND& window, const WNDPROC& gameWindowProc) : window(window), gameWindowProc(gameWindowProc)
+	{
+	}
+
+	int64_t Now() override
+	{
+		return clock.Now();
+	}
+
+	void GetMonitors(std::vector<MonitorInfo>& monitors) override
 	{
-		crc = crc ^ data[i];
-		for (size_t j = 0; j < 8; j++)
+		calls++;
+		EnumDisplayMonitors(NULL, NULL, [](HMONITOR monitor, HDC, LPRECT, LPARAM param) -> BOOL
 		{
-			DWORD mask = ~(crc & 1) + 1;
-			crc = (crc >> 1) ^ (0xEDB88320 & mask);
-		}
+			MONITORINFOEX info = {};
+			info.cbSize = sizeof(info);
+			if (!GetMonitorInfo(monitor, &info))
+				return TRUE; // skip
+
+			DEVMODE mode = {};
+			mode.dmSize = sizeof(mode);
+			auto refreshRate = EnumDisplaySettings(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) ? mode.dmDisplayFrequency : 0;
+			if (refreshRate <= 1) refreshRate = 0; // 0 and 1 mean hardware default
+
+			static auto getDpiForMonitor = (HRESULT(WINAPI*)(HMONITOR, int, UINT*, UINT*))GetProcAddress(LoadLibrary("shcore.dll"), "GetDpiForMonitor"); // Windows 8.1+
+			UINT dpiX = 0, dpiY = 0;
+			if (!getDpiForMonitor || FAILED(getDpiForMonitor(monitor, 0, &dpiX, &dpiY)) || !dpiX) // MDT_EFFECTIVE_DPI
+				dpiX = USER_DEFAULT_SCREEN_DPI;
+
+			auto& rect = info.rcMonitor;
+			auto& work = info.rcWork;
+			((std::vector<MonitorInfo>*)param)->push_back({
+				{ rect.left, rect.top, rect.right, rect.bottom },
+				{ work.left, work.top, work.right, work.bottom },
+				refreshRate,
+				dpiX,
+				(info.dwFlags & MONITORINFOF_PRIMARY) != 0
+			});
+			return TRUE;
+		}, (LPARAM)&monitors);
 	}
-	return ~crc;
-}
 
-static inline RECT GetMonitorRect(POINT pos)
+	bool IsMaximized() override
+	{
+		calls++;
+		return window && IsZoomed(window);
+	}
+
+	bool IsMinimized() override
+	{
+		calls++;
+		return window && IsIconic(window);
+	}
+
+	bool IsForeground() override
+	{
+		calls++;
+		return window && GetForegroundWindow() == window;
+	}
+
+	bool GetWindowRect(PlatformRect& rect) override
+	{
+		calls++;
+		RECT bounds;
+		if (!window || !::GetWindowRect(window, &bounds))
+			return false;
+
+		rect = { bounds.left, bounds.top, bounds.right, bounds.bottom };
+		return true;
+	}
+
+	bool GetClientRect(PlatformRect& rect) override
+	{
+		calls++;
+		RECT client;
+		if (!window || !::GetClientRect(window, &client))
+			return false;
+
+		ClientToScreen(window, (LPPOINT)&client.left); // left & top
+		ClientToScreen(window, (LPPOINT)&client.right); // right & bottom
+		rect = { client.left, client.top, client.right, client.bottom };
+		return true;
+	}
+
+	void SetStyle(uint32_t style, uint32_t exStyle) override
+	{
+		calls++;
+		SetWindowLong(window, GWL_STYLE, style);
+		SetWindowLong(window, GWL_EXSTYLE, exStyle);
+		SetWindowPos(window, 0, 0, 0, 0, 0, SWP_NOOWNERZORDER | SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOSIZE | SWP_NOSENDCHANGING | SWP_FRAMECHANGED | SWP_SHOWWINDOW); // update the frame
+	}
+
+	void Move(PlatformPoint pos, PlatformPoint size, bool show) override
+	{
+		calls++;
+		SetWindowPos(window, 0, pos.x, pos.y, size.x, size.y,
+			SWP_NOOWNERZORDER | SWP_NOSENDCHANGING | (show ? SWP_SHOWWINDOW : SWP_NOZORDER | SWP_NOACTIVATE));
+	}
+
+	void Invalidate() override
+	{
+		calls++;
+		InvalidateRect(window, NULL, TRUE);
+	}
+
+	void Post(uint32_t message, uintptr_t wParam, intptr_t lParam) override
+	{
+		calls++;
+		PostMessage(window, message, wParam, lParam);
+	}
+
+	bool IsWindowThread() override
+	{
+		calls++;
+		return !window || GetWindowThreadProcessId(window, NULL) == GetCurrentThreadId();
+	}
+
+	void SetTimer(uintptr_t id, uint32_t interval) override
+	{
+		calls++;
+		::SetTimer(window, id, interval, NULL);
+	}
+
+	void KillTimer(uintptr_t id) override
+	{
+		calls++;
+		::KillTimer(window, id);
+	}
+
+	intptr_t ForwardMessage(uint32_t message, uintptr_t wParam, intptr_t lParam) override
+	{
+		calls++;
+		return CallWindowProc(gameWindowProc, window, message, wParam, lParam);
+	}
+
+protected:
+	const HWND& window;
+	const WNDPROC& gameWindowProc;
+	QpcClock clock;
+};
+
+class Win32PatchMemory : public PatchMemory
 {
-	auto monitor = MonitorFromPoint(pos, MONITOR_DEFAULTTONEAREST);
-	MONITORINFO info = { sizeof(MONITORINFO) };
+public:
+	bool Unprotect(uintptr_t page, uint32_t& oldProtection) override
+	{
+		DWORD protection;
+		if (!VirtualProtect((LPVOID)page, PageSize, PAGE_EXECUTE_READWRITE, &protection))
+			return false;
 
-	if (!GetMonitorInfo(monitor, &info))
+		oldProtection = protection;
+		return true;
+	}
+
+	void Protect(uintptr_t page, uint32_t protection) override
 	{
-		monitor = MonitorFromPoint(pos, MONITOR_DEFAULTTOPRIMARY);
-		GetMonitorInfo(monitor, &info);
+		DWORD unused;
+		VirtualProtect((LPVOID)page, PageSize, protection, &unused);
 	}
 
-	return info.rcMonitor;
-}
+	void FlushCode(uintptr_t address, size_t size) override
+	{
+		FlushInstructionCache(GetCurrentProcess(), (LPCVOID)address, size);
+	}
 
-static inline bool HasFocus(HWND wnd)
+	void Read(uintptr_t address, void* data, size_t size) override
+	{
+		memcpy(data, (const void*)address, size);
+	}
+
+	void Write(uintptr_t address, const void* data, size_t size) override
+	{
+		memcpy((void*)address, data, size);
+	}
+};
+
+// address of the import table entry of given function, nullptr if the module does not import it
+static inline uintptr_t* FindImport(HMODULE module, const char* dllName, const char* functionName)
 {
-	return GetForegroundWindow() == wnd;
+	auto base = (BYTE*)module;
+	auto header = (IMAGE_NT_HEADERS*)(base + ((IMAGE_DOS_HEADER*)base)->e_lfanew);
+	auto& directory = header->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+	if (!directory.VirtualAddress)
+		return nullptr;
+
+	auto dll = GetModuleHandle(dllName);
+	auto function = dll ? (uintptr_t)GetProcAddress(dll, functionName) : 0;
+
+	for (auto desc = (IMAGE_IMPORT_DESCRIPTOR*)(base + directory.VirtualAddress); desc->Name; desc++)
+	{
+		if (_stricmp((const char*)(base + desc->Name), dllName))
+			continue;
+
+		auto thunks = (uintptr_t*)(base + desc->FirstThunk);
+		auto names = desc->OriginalFirstThunk ? (IMAGE_THUNK_DATA*)(base + desc->OriginalFirstThunk) : nullptr;
+		for (size_t i = 0; thunks[i]; i++)
+		{
+			if (names && !IMAGE_SNAP_BY_ORDINAL(names[i].u1.Ordinal))
+			{
+				auto import = (IMAGE_IMPORT_BY_NAME*)(base + names[i].u1.AddressOfData);
+				if (!strcmp((const char*)import->Name, functionName)) return &thunks[i];
+			}
+			else if (function && thunks[i] == function) // import names stripped
+				return &thunks[i];
+		}
+	}
+
+	return nullptr;
 }
 
-static inline bool IsCursorInClientRect(HWND wnd)
+// top level window of this process with given class, NULL if not created yet
+static inline HWND FindProcessWindow(const char* className)
 {
-	POINT pos;
-	GetCursorPos(&pos);
-
-	RECT rect;
-	GetClientRect(wnd, &rect);
-	ClientToScreen(wnd, (LPPOINT)&rect.left); // left& top
-	ClientToScreen(wnd, (LPPOINT)&rect.right); // right & bottom
+	struct Search
+	{
+		const char* className;
+		HWND window;
+	} search = { className, NULL };
 
-	return PtInRect(&rect, pos);
+	EnumWindows([](HWND window, LPARAM param) -> BOOL
+	{
+		auto& search = *(Search*)param;
+		DWORD process = 0;
+		char name[64];
+		GetWindowThreadProcessId(window, &process);
+		if (process != GetCurrentProcessId() || !GetClassName(window, name, sizeof(name)) || _stricmp(name, search.className))
+			return TRUE; // continue
+
+		search.window = window;
+		return FALSE;
+	}, (LPARAM)&search);
+
+	return search.window;
 }
 
 static inline bool IsKeyDown(int keyCode)
@@ -488,11 +756,21 @@ static inline void SetCursorVisible(bool show)
 	}
 }
 
+// set while in DllMain, a message box there would run under the loader lock. One instance shared by all translation units
+inline bool errorsDeferred = false;
+inline std::string deferredErrors;
+
 template <class ... Args>
 static void ShowError(const char* format, Args ... args)
 {
 	auto msg = StringPrintf(format, args...);
 
+	if (errorsDeferred)
+	{
+		deferredErrors += deferredErrors.empty() ? msg : "\n\n" + msg;
+		return;
+	}
+
 	auto wnd = GetActiveWindow();
 	if (wnd)
 	{
@@ -504,15 +782,112 @@ static void ShowError(const char* format, Args ... args)
 	MessageBoxA(wnd, msg.c_str(), rsc_ProductName, MB_SYSTEMMODAL | MB_ICONERROR);
 }
 
-static inline void VerifyMemory(const char* name, DWORD address, size_t size, DWORD expectedHash)
+static DWORD WINAPI ShowDeferredErrorsThread(LPVOID)
+{
+	ShowError("%s", deferredErrors.c_str());
+	return 0;
+}
+
+// shows errors held back in DllMain, the thread starts running once the loader lock is released
+static inline void ShowDeferredErrors()
+{
+	errorsDeferred = false;
+	if (deferredErrors.empty())
+		return;
+
+	auto thread = CreateThread(NULL, 0, &ShowDeferredErrorsThread, NULL, 0, NULL);
+	if (thread) CloseHandle(thread);
+}
+
+// Check if somebody already modified memory we want to hook, reports all modified sites at once.
+// Runs in every build. Only debug builds stop with a message, release ones write to debug output,
+// as other mods hooking the same code often work fine together with this one.
+template <size_t Count>
+static inline bool VerifyMemory(const PatchSite (&sites)[Count])
+{
+	std::string report;
+	auto mismatches = VerifyPatchSites(sites, Count, [&](const PatchSite& site, uint32_t hash)
+	{
+		if (!report.empty()) report += "\n\n";
+		report += StringPrintf("Memory \"%s\" modified!\nExpected hash: 0x%08X\nActual hash: 0x%08X", site.name, site.hash, hash);
+	});
+
+	if (mismatches)
+	{
+#ifdef DEBUG
+		ShowError("%s", report.c_str());
+#else
+		OutputDebugStringA(StringPrintf(rsc_ProductName ": %s\n", report.c_str()).c_str());
+#endif
+	}
+
+	return !mismatches;
+}
+
+// applies all the patches at once, memory stays untouched if any of them fails
+template <size_t Count>
+static inline bool ApplyPatches(const PatchOp (&ops)[Count])
+{
+	Win32PatchMemory memory;
+	PatchTransaction transaction(memory);
+
+	auto result = transaction.Apply(ops);
+	if (result != PatchTransaction::Success)
+	{
+		ShowError("Failed to apply memory patches!\nError: %d", result);
+	}
+
+	return result == PatchTransaction::Success;
+}
+
+// Executable memory for hook thunks, allocated once and never released
+class HookThunkArena
 {
-	auto buffer = std::vector<BYTE>(size);
-	injector::ReadMemoryRaw(address, buffer.data(), size, true);
-	auto hash = Crc32(buffer.data(), size);
+public:
+	// page stays writable until Seal, thunks already on it keep running meanwhile
+	static uint8_t* Allocate(size_t size)
+	{
+		size = (size + 15) & ~size_t(15);
+		if (used + size > PatchMemory::PageSize)
+			return nullptr;
 
-	if (hash != expectedHash)
+		DWORD oldProtection;
+		if (!page)
+		{
+			page = (uint8_t*)VirtualAlloc(NULL, PatchMemory::PageSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+			if (!page) return nullptr;
+		}
+		else if (!VirtualProtect(page, PatchMemory::PageSize, PAGE_EXECUTE_READWRITE, &oldProtection))
+			return nullptr;
+
+		auto block = page + used;
+		used += size;
+		return block;
+	}
+
+	// once the code is emitted, the page is executable and read only
+	static void Seal(const uint8_t* block, size_t size)
 	{
-		ShowError("Memory \"%s\" modified!\nExpected hash: 0x%08X\nActual hash: 0x%08X", name, expectedHash, hash);
+		DWORD oldProtection;
+		VirtualProtect(page, PatchMemory::PageSize, PAGE_EXECUTE_READ, &oldProtection);
+		FlushInstructionCache(GetCurrentProcess(), block, size);
 	}
+
+protected:
+	static inline uint8_t* page = nullptr;
+	static inline size_t used = 0;
+};
+
+// Builds thunk calling Patch functor with only the registers listed in Patch::Regs saved, then jumping to returnAddress.
+// Returns address of the thunk to be used as jump target of PatchOp::MakeJMP, 0 if out of memory.
+template <class Patch>
+static inline uintptr_t MakeHookThunk(uintptr_t returnAddress)
+{
+	auto code = HookThunkArena::Allocate(HookThunkBuilder::MaxSize);
+	if (!code) return 0;
+
+	auto size = HookThunkBuilder::Build(code, HookThunkBuilder::MaxSize, (uintptr_t)code, Patch::Regs::Mask, (uintptr_t)&HookThunkCallback<Patch>::Invoke, returnAddress);
+	HookThunkArena::Seal(code, size);
+	return size ? (uintptr_t)code : 0;
 }
 
@@ -0,0 +1,333 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "Test.h"
+#include "WindowController.h"
+#include "PatchTransaction.h"
+#include "DeviceVTable.h"
+
+// Manually advanced clock, copies share the time
+struct FakeClock
+{
+	int64_t* time;
+	int64_t step = 0; // added on every read, lets spinning waits finish
+
+	int64_t Now() const
+	{
+		return *time += step;
+	}
+
+	void Sleep(int64_t ns) const
+	{
+		*time += ns;
+	}
+};
+
+// Real clock for the benchmarks
+struct SteadyClock
+{
+	int64_t Now() const
+	{
+		return Test::Now();
+	}
+
+	void Sleep(int64_t ns) const
+	{
+		std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+	}
+};
+
+// Simulated window on a simulated desktop, standing in for both the window platform and the frame metrics.
+// Frames look like Windows 10: 8 pixels thick borders (7 of them invisible) and 31 pixels tall caption at 96 DPI.
+class FakeWindow : public WindowPlatform, public GeometrySource
+{
+public:
+	static constexpr uint32_t Captioned = 1; // window style with frame, anything else is borderless
+
+	struct Message
+	{
+		uint32_t message;
+		uintptr_t wParam;
+		intptr_t lParam;
+	};
+
+	int64_t time = 0; // ns
+	std::vector<MonitorInfo> displays = { { { 0, 0, 1920, 1080 }, { 0, 0, 1920, 1040 }, 60, 96, true } };
+	bool exists = true; // window created
+	PlatformRect rect = {}; // outer window rect
+	uint32_t style = Captioned;
+	uint32_t dpi = 96;
+	bool maximized = false;
+	bool minimized = false;
+	bool foreground = true;
+	std::thread::id windowThread = std::this_thread::get_id(); // created by
+
+	// what the window code did
+	std::vector<Message> posted;
+	std::vector<Message> forwarded; // to the game
+	uint32_t moves = 0;
+	uint32_t invalidations = 0;
+	uintptr_t timer = 0; // running timer id, 0 if none
+	uint32_t timerInterval = 0;
+
+	int64_t Now() override
+	{
+		return time;
+	}
+
+	void GetMonitors(std::vector<MonitorInfo>& monitors) override
+	{
+		calls++;
+		monitors.insert(monitors.end(), displays.begin(), displays.end());
+	}
+
+	bool IsMaximized() override
+	{
+		calls++;
+		return exists && maximized;
+	}
+
+	bool IsMinimized() override
+	{
+		calls++;
+		return exists && minimized;
+	}
+
+	bool IsForeground() override
+	{
+		calls++;
+		return exists && foreground;
+	}
+
+	bool GetWindowRect(PlatformRect& rect) override
+	{
+		calls++;
+		rect = this->rect;
+		return exists;
+	}
+
+	bool GetClientRect(PlatformRect& rect) override
+	{
+		calls++;
+		auto frame = AdjustFrame(style, 0, dpi);
+		rect = { this->rect.left + frame.left, this->rect.top + frame.top, this->rect.right - frame.right, this->rect.bottom - frame.bottom };
+		return exists;
+	}
+
+	void SetStyle(uint32_t style, uint32_t) override
+	{
+		calls++;
+		this->style = style;
+	}
+
+	void Move(PlatformPoint pos, PlatformPoint size, bool) override
+	{
+		calls++;
+		moves++;
+		rect = { pos.x, pos.y, pos.x + size.x, pos.y + size.y };
+	}
+
+	void Invalidate() override
+	{
+		calls++;
+		invalidations++;
+	}
+
+	void Post(uint32_t message, uintptr_t wParam, intptr_t lParam) override
+	{
+		calls++;
+		posted.push_back({ message, wParam, lParam });
+	}
+
+	intptr_t ForwardMessage(uint32_t message, uintptr_t wParam, intptr_t lParam) override
+	{
+		calls++;
+		forwarded.push_back({ message, wParam, lParam });
+		return 0;
+	}
+
+	bool IsWindowThread() override
+	{
+		calls++;
+		return std::this_thread::get_id() == windowThread;
+	}
+
+	void SetTimer(uintptr_t id, uint32_t interval) override
+	{
+		calls++;
+		timer = id;
+		timerInterval = interval;
+	}
+
+	void KillTimer(uintptr_t id) override
+	{
+		calls++;
+		if (timer == id)
+			timer = 0;
+	}
+
+	// GeometrySource
+
+	GeometryInsets AdjustFrame(uint32_t style, uint32_t, uint32_t dpi) override
+	{
+		if (style != Captioned)
+			return {};
+
+		return ScaleForDpi(GeometryInsets{ 8, 31, 8, 8 }, 96, dpi);
+	}
+
+	bool QueryPadding(GeometryInsets& padding) override
+	{
+		if (!exists)
+			return false;
+
+		padding = style == Captioned ? ScaleForDpi(GeometryInsets{ 7, 0, 7, 7 }, 96, dpi) : GeometryInsets{};
+		return true;
+	}
+
+	uint32_t QueryDpi() override
+	{
+		return dpi;
+	}
+
+	const void* QueryMonitor() override
+	{
+		return &displays[0];
+	}
+};
+
+// Window controller with the game replaced by records of what it was told
+class FakeGameWindow : public WindowController
+{
+public:
+	std::vector<PlatformPoint> backBuffers; // sizes handed over to the game
+	uint32_t titleUpdates = 0;
+
+	FakeGameWindow(FakeWindow& window) : WindowController(window, window)
+	{
+	}
+
+	uint32_t WindowStyle() const override
+	{
+		return windowMode == WindowMode::Windowed ? FakeWindow::Captioned : 0;
+	}
+
+	uint32_t WindowStyleEx() const override
+	{
+		return 0;
+	}
+
+	void WindowUpdateTitle(const PlatformPoint*) override
+	{
+		titleUpdates++;
+	}
+
+	void ApplyBackBuffer() override
+	{
+		backBuffers.push_back(backBufferSize);
+	}
+};
+
+// Patches the memory of this process directly, nothing is protected
+class FakePatchMemory : public PatchMemory
+{
+public:
+	bool Unprotect(uintptr_t, uint32_t& oldProtection) override
+	{
+		oldProtection = 0;
+		return true;
+	}
+
+	void Protect(uintptr_t, uint32_t) override
+	{
+	}
+
+	void FlushCode(uintptr_t, size_t) override
+	{
+	}
+
+	void Read(uintptr_t address, void* data, size_t size) override
+	{
+		memcpy(data, (const void*)address, size);
+	}
+
+	void Write(uintptr_t address, const void* data, size_t size) override
+	{
+		memcpy((void*)address, data, size);
+	}
+};
+
+#if defined(_M_IX86) || defined(__i386__)
+#if defined(_MSC_VER)
+#define FAKE_STDCALL __stdcall
+#else
+#define FAKE_STDCALL __attribute__((stdcall))
+#endif
+#else
+#define FAKE_STDCALL // single calling convention
+#endif
+
+// Object laid out like IDirect3DDevice8/9: pointer to a table of methods taking the object first.
+// Only Reset and Present do something, any other slot called is counted as error.
+template <bool D3D9>
+class FakeDevice
+{
+public:
+	using Table = DeviceVTable<D3D9>;
+	using PresentFunc = long (FAKE_STDCALL*)(FakeDevice* self, const void* srcRect, const void* dstRect, void* wnd, const void* region);
+	using ResetFunc = long (FAKE_STDCALL*)(FakeDevice* self, void* parameters);
+
+	static constexpr size_t SlotCount = 18; // enough for IDirect3DDevice9::Present
+
+	uintptr_t* vTable = slots; // first member, like in a COM object
+	uintptr_t slots[SlotCount];
+	uint32_t presents = 0;
+	uint32_t resets = 0;
+	uint32_t unexpected = 0;
+
+	FakeDevice()
+	{
+		for (auto& slot : slots)
+			slot = (uintptr_t)&Unexpected;
+
+		slots[Table::Reset] = (uintptr_t)&Reset;
+		slots[Table::Present] = (uintptr_t)&Present;
+	}
+
+	// calls through the table, like the game does
+	long CallPresent()
+	{
+		return ((PresentFunc)vTable[Table::Present])(this, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	long CallReset(void* parameters)
+	{
+		return ((ResetFunc)vTable[Table::Reset])(this, parameters);
+	}
+
+	long CallSlot(size_t slot)
+	{
+		return ((ResetFunc)vTable[slot])(this, nullptr);
+	}
+
+protected:
+	static long FAKE_STDCALL Present(FakeDevice* self, const void*, const void*, void*, const void*)
+	{
+		self->presents++;
+		return 0;
+	}
+
+	static long FAKE_STDCALL Reset(FakeDevice* self, void*)
+	{
+		self->resets++;
+		return 0;
+	}
+
+	static long FAKE_STDCALL Unexpected(FakeDevice* self, void*)
+	{
+		self->unexpected++;
+		return -1;
+	}
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <map>
+#include "Fakes.h"
+
+// Feeds a message trace saved by Ctrl+Alt+T into the simulated window, so it can be inspected and re-run off Windows.
+// Messages reach the controller the way WindowedMode's window procedure hands them over, work done is counted again.
+// Replay starts in borderless fullscreen like InitWindow does, trace may begin in the middle of a session though.
+// Messages sent from within a handler are in the trace too, the simulated window does not generate them again.
+class MessageReplay
+{
+public:
+	// Win32 values of the messages the window code reacts to
+	enum Message : uint32_t
+	{
+		Size = 0x0005, // WM_SIZE
+		Activate = 0x0006, // WM_ACTIVATE
+		SettingChange = 0x001A, // WM_SETTINGCHANGE
+		WindowPosChanged = 0x0047, // WM_WINDOWPOSCHANGED
+		StyleChanged = 0x007D, // WM_STYLECHANGED
+		DisplayChange = 0x007E, // WM_DISPLAYCHANGE
+		Timer = 0x0113, // WM_TIMER
+		Sizing = 0x0214, // WM_SIZING
+		ExitSizeMove = 0x0232, // WM_EXITSIZEMOVE
+		DpiChanged = 0x02E0, // WM_DPICHANGED
+		GetDpiScaledSize = 0x02E4, // WM_GETDPISCALEDSIZE
+	};
+	static constexpr uint32_t SetWorkArea = 0x002F; // SPI_SETWORKAREA
+
+	struct Totals
+	{
+		uint32_t messages;
+		uint32_t geometry;
+		uint32_t resets;
+		uint32_t platformCalls;
+	};
+
+	FakeWindow window;
+	FakeGameWindow game{ window };
+	std::map<uint32_t, Totals> perMessage; // replayed work by message
+
+	MessageReplay()
+	{
+		game.windowMode = WindowController::Fullscreen;
+		game.WindowCalculateGeometry(true);
+		game.BeforeDeviceCreate();
+	}
+
+	// hands one message to the controller, returns work done
+	MessageWork Dispatch(uint32_t message, uint32_t wParam, uint32_t lParam)
+	{
+		auto start = game.GetWork();
+		uint32_t flags;
+
+		switch (message)
+		{
+			case Activate:
+				window.foreground = (wParam & 0xFFFF) != 0;
+				game.inputState.SetFocus(window.foreground);
+				if (window.foreground) window.ForwardMessage(message, wParam, lParam);
+				break;
+
+			case WindowPosChanged:
+			{
+				auto size = MessageTrace::UnpackSize(lParam, flags);
+				auto pos = MessageTrace::UnpackPoint(wParam);
+
+				// window is already there when the message arrives
+				auto& rect = window.rect;
+				PlatformPoint newPos = (flags & WindowController::NoMove) ? PlatformPoint{ rect.left, rect.top } : pos;
+				PlatformPoint newSize = (flags & WindowController::NoSize) ? PlatformPoint{ rect.right - rect.left, rect.bottom - rect.top } : size;
+				rect = { newPos.x, newPos.y, newPos.x + newSize.x, newPos.y + newSize.y };
+
+				game.OnWindowPosChanged(pos, size, flags);
+				window.ForwardMessage(message, wParam, lParam);
+				break;
+			}
+
+			case Sizing:
+			{
+				auto size = MessageTrace::UnpackPoint(lParam);
+				PlatformRect rect = { window.rect.left, window.rect.top, window.rect.left + size.x, window.rect.top + size.y };
+				game.OnSizing(wParam, rect);
+				break;
+			}
+
+			case ExitSizeMove:
+				game.OnExitSizeMove();
+				break;
+
+			case Size:
+				game.ForwardSize(wParam, { int32_t(lParam & 0xFFFF), int32_t(lParam >> 16) });
+				break;
+
+			case WindowController::WM_WINDOWEDMODE_COMMANDS:
+				game.DrainCommands();
+				break;
+
+			case Timer:
+				if (!game.OnTimer(wParam)) window.ForwardMessage(message, wParam, lParam);
+				break;
+
+			case StyleChanged:
+				game.OnStyleChanged();
+				window.ForwardMessage(message, wParam, lParam);
+				break;
+
+			case DisplayChange:
+				game.OnDisplayChange();
+				window.ForwardMessage(message, wParam, lParam);
+				break;
+
+			case SettingChange:
+				if (wParam == SetWorkArea) game.OnWorkAreaChange();
+				window.ForwardMessage(message, wParam, lParam);
+				break;
+
+			case GetDpiScaledSize:
+				game.GetDpiScaledSize(wParam & 0xFFFF);
+				break;
+
+			case DpiChanged:
+				window.dpi = wParam & 0xFFFF;
+				game.OnDpiChanged(window.dpi, MessageTrace::UnpackPoint(lParam));
+				break;
+
+			default:
+				window.ForwardMessage(message, wParam, lParam);
+				break;
+		}
+
+		window.posted.clear(); // posted messages are in the trace on their own
+		window.forwarded.clear();
+
+		auto end = game.GetWork();
+		return { end.geometry - start.geometry, end.resets - start.resets, end.platformCalls - start.platformCalls };
+	}
+
+	// replays all records at their recorded times, returns work recorded by top level messages and replayed work of all
+	void Run(const MessageTrace& trace, Totals& recorded, Totals& replayed)
+	{
+		recorded = replayed = {};
+		for (uint32_t i = 0; i < trace.GetCount(); i++)
+		{
+			auto& record = trace.Get(i);
+			window.time = record.time;
+
+			if (record.depth == 0) // nested work is included in the message sending it
+			{
+				recorded.messages++;
+				recorded.geometry += record.geometry;
+				recorded.resets += record.resets;
+				recorded.platformCalls += record.platformCalls;
+			}
+
+			auto work = Dispatch(record.message, record.wParam, record.lParam);
+			for (auto totals : { &replayed, &perMessage[record.message] })
+			{
+				totals->messages++;
+				totals->geometry += work.geometry;
+				totals->resets += work.resets;
+				totals->platformCalls += work.platformCalls;
+			}
+		}
+	}
+
+	void Print(const Totals& recorded, const Totals& replayed) const
+	{
+		printf("%-10s %10s %10s %10s %10s\n", "message", "count", "geometry", "resets", "calls");
+		for (auto& [message, totals] : perMessage)
+			printf("0x%04X     %10u %10u %10u %10u\n", message, totals.messages, totals.geometry, totals.resets, totals.platformCalls);
+
+		printf("%-10s %10u %10u %10u %10u\n", "recorded", recorded.messages, recorded.geometry, recorded.resets, recorded.platformCalls);
+		printf("%-10s %10u %10u %10u %10u\n", "replayed", replayed.messages, replayed.geometry, replayed.resets, replayed.platformCalls);
+	}
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+// Minimal self registering test runner. Tests and benchmarks are plain functions,
+// benchmarks only run when asked for with --bench.
+namespace Test
+{
+	struct Case
+	{
+		const char* name;
+		void (*func)();
+		bool benchmark;
+	};
+
+	inline std::vector<Case>& Cases()
+	{
+		static std::vector<Case> cases;
+		return cases;
+	}
+
+	inline uint32_t failures = 0;
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*func)(), bool benchmark)
+		{
+			Cases().push_back({ name, func, benchmark });
+		}
+	};
+
+	inline void Fail(const char* file, int line, const char* expression)
+	{
+		failures++;
+		printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+	}
+
+	inline int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// runs func given number of times, prints time per call
+	template <class Func>
+	void Measure(const char* name, uint64_t iterations, Func&& func)
+	{
+		auto start = Now();
+		for (uint64_t i = 0; i < iterations; i++)
+			func(i);
+		auto duration = Now() - start;
+
+		printf("  %-40s %10.1f ns/op %14.0f op/s\n", name, double(duration) / iterations, iterations * 1e9 / (duration ? duration : 1));
+	}
+}
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+	static void name(); \
+	static Test::Registrar TEST_CONCAT(name, Registrar)(#name, &name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static Test::Registrar TEST_CONCAT(name, Registrar)(#name, &name, true); \
+	static void name()
+
+#define CHECK(expression) do { if (!(expression)) Test::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+// keeps the optimizer from removing benchmarked work
+template <class T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
@@ -0,0 +1,84 @@
+#include "Test.h"
+#include "FocusThrottle.h"
+#include <atomic>
+#include <thread>
+
+TEST(FocusThrottleStates)
+{
+	FocusThrottle throttle;
+	CHECK(throttle.GetState() == FocusThrottle::Active);
+	CHECK(!throttle.IsThrottled() && throttle.ShouldPresent());
+
+	throttle.OnActivate(false, false); // alt-tabbed, still visible
+	CHECK(throttle.GetState() == FocusThrottle::Background);
+	CHECK(throttle.IsThrottled() && throttle.ShouldPresent());
+
+	throttle.OnMinimize(true);
+	CHECK(throttle.GetState() == FocusThrottle::Minimized);
+	CHECK(!throttle.ShouldPresent());
+
+	throttle.skipPresentMinimized = false;
+	CHECK(throttle.ShouldPresent());
+
+	throttle.OnMinimize(false);
+	CHECK(throttle.GetState() == FocusThrottle::Background);
+	throttle.OnActivate(true, false);
+	CHECK(throttle.GetState() == FocusThrottle::Active);
+}
+
+TEST(FocusThrottleResumesOnce)
+{
+	FocusThrottle throttle;
+	CHECK(!throttle.ConsumeResume());
+
+	throttle.OnActivate(false, false);
+	CHECK(!throttle.ConsumeResume());
+
+	throttle.OnActivate(true, false);
+	CHECK(throttle.ConsumeResume());
+	CHECK(!throttle.ConsumeResume());
+
+	throttle.OnActivate(true, false); // still active, nothing to resume from
+	CHECK(!throttle.ConsumeResume());
+}
+
+TEST(FocusThrottleDisabled)
+{
+	FocusThrottle throttle;
+	throttle.enabled = false;
+
+	throttle.OnActivate(false, true);
+	CHECK(throttle.GetState() == FocusThrottle::Active);
+	CHECK(!throttle.IsThrottled() && throttle.ShouldPresent());
+	CHECK(!throttle.ConsumeResume());
+}
+
+// present hook running on its own thread while focus changes arrive, checked by the TSan configuration
+TEST(FocusThrottleAcrossThreads)
+{
+	FocusThrottle throttle;
+	std::atomic<bool> running = true;
+	uint32_t presents = 0, resumes = 0;
+
+	std::thread presentThread([&]
+	{
+		while (running)
+		{
+			if (throttle.ShouldPresent()) presents++;
+			if (throttle.ConsumeResume()) resumes++;
+		}
+	});
+
+	for (int i = 0; i < 20000; i++)
+	{
+		throttle.OnActivate(false, false);
+		throttle.OnMinimize(i % 2 == 0);
+		throttle.OnActivate(true, false);
+	}
+	running = false;
+	presentThread.join();
+
+	CHECK(throttle.GetState() == FocusThrottle::Active);
+	CHECK(resumes <= 20000);
+	DoNotOptimize(presents);
+}
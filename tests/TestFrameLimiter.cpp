@@ -0,0 +1,59 @@
+#include "Fakes.h"
+#include "FramePacer.h"
+
+// runs frames taking no time, returns time they took with the limiter
+static int64_t LimitFrames(FrameLimiter<FakeClock>& limiter, int64_t& time, FrameLimiter<FakeClock>::Context context, int frames)
+{
+	time = 0;
+	limiter.pacer.Reset();
+	for (int i = 0; i < frames; i++)
+		limiter.Limit(context);
+	return time;
+}
+
+TEST(FrameLimiterConfigTarget)
+{
+	using Limiter = FrameLimiter<FakeClock>;
+	CHECK(Limiter::ConfigTarget(-1) == Limiter::RefreshRate);
+	CHECK(Limiter::ConfigTarget(-100) == Limiter::RefreshRate);
+	CHECK(Limiter::ConfigTarget(0) == 0);
+	CHECK(Limiter::ConfigTarget(144) == 144);
+}
+
+TEST(FrameLimiterFollowsRefreshRate)
+{
+	int64_t time = 0;
+	FrameLimiter<FakeClock> limiter(FakeClock{ &time });
+	limiter.pacer.strategy = PacingStrategy::Sleep;
+	limiter.targets[limiter.Gameplay] = limiter.RefreshRate;
+
+	limiter.refreshRate = 0; // unknown monitor, not limited
+	CHECK(LimitFrames(limiter, time, limiter.Gameplay, 10) == 0);
+
+	limiter.refreshRate = 100;
+	auto duration = LimitFrames(limiter, time, limiter.Gameplay, 10);
+	CHECK(duration >= 9 * 10000000 && duration <= 10 * 10000000);
+
+	limiter.refreshRate = 50; // window moved to another monitor
+	duration = LimitFrames(limiter, time, limiter.Gameplay, 10);
+	CHECK(duration >= 9 * 20000000 && duration <= 10 * 20000000);
+}
+
+TEST(FrameLimiterSeparateTargets)
+{
+	int64_t time = 0;
+	FrameLimiter<FakeClock> limiter(FakeClock{ &time });
+	limiter.pacer.strategy = PacingStrategy::Sleep;
+	limiter.refreshRate = 60;
+	limiter.targets[limiter.Gameplay] = 0;
+	limiter.targets[limiter.Menu] = limiter.RefreshRate;
+	limiter.targets[limiter.Unfocused] = 5;
+
+	CHECK(LimitFrames(limiter, time, limiter.Gameplay, 10) == 0);
+
+	auto duration = LimitFrames(limiter, time, limiter.Menu, 61);
+	CHECK(duration >= 999000000 && duration <= 1017000000);
+
+	duration = LimitFrames(limiter, time, limiter.Unfocused, 6);
+	CHECK(duration >= 1000000000 && duration <= 1200000000);
+}
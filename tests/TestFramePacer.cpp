@@ -0,0 +1,129 @@
+#include "Fakes.h"
+#include "FramePacer.h"
+
+// sleeps always take longer than asked for, like Sleep() with 1ms timer resolution
+struct OversleepingClock
+{
+	int64_t* time;
+	int64_t oversleep;
+	uint32_t* sleeps;
+
+	int64_t Now() const
+	{
+		return *time;
+	}
+
+	void Sleep(int64_t ns) const
+	{
+		*time += ns + oversleep;
+		(*sleeps)++;
+	}
+};
+
+TEST(FramePacerKeepsCadence)
+{
+	int64_t time = 0;
+	FramePacer<FakeClock> pacer(FakeClock{ &time });
+	pacer.strategy = PacingStrategy::Sleep;
+	pacer.SetTarget(100);
+	CHECK(pacer.GetInterval() == 10000000);
+
+	for (int i = 0; i < 100; i++)
+	{
+		time += 3000000; // frame work
+		pacer.Wait();
+	}
+
+	CHECK(time == 3000000 + 99 * 10000000); // first frame starts the cadence
+}
+
+TEST(FramePacerOversleepDoesNotAccumulate)
+{
+	int64_t time = 0;
+	uint32_t sleeps = 0;
+	FramePacer<OversleepingClock> pacer(OversleepingClock{ &time, 1000000, &sleeps });
+	pacer.strategy = PacingStrategy::Sleep;
+	pacer.SetTarget(100);
+
+	for (int i = 0; i < 100; i++)
+	{
+		time += 3000000;
+		pacer.Wait();
+	}
+
+	// each frame is late by the oversleep, but deadlines stay on the 10ms grid
+	CHECK(time == 3000000 + 99 * 10000000 + 1000000);
+	CHECK(sleeps == 99);
+}
+
+TEST(FramePacerHybridSpinsLastPart)
+{
+	int64_t time = 0;
+	FramePacer<FakeClock> pacer(FakeClock{ &time, 1000 }); // each clock read takes 1us
+	pacer.strategy = PacingStrategy::Hybrid;
+	pacer.SetTarget(100);
+
+	pacer.Wait();
+	auto deadline = time + 10000000;
+	time += 1000000;
+	auto waited = pacer.Wait();
+
+	CHECK(time >= deadline && time < deadline + 2000); // spun right up to the deadline
+	CHECK(waited >= 9000000 - 2000);
+}
+
+TEST(FramePacerRestartsAfterStall)
+{
+	int64_t time = 0;
+	FramePacer<FakeClock> pacer(FakeClock{ &time });
+	pacer.strategy = PacingStrategy::Sleep;
+	pacer.SetTarget(100);
+
+	pacer.Wait();
+	time += 50000000; // loading screen
+	CHECK(pacer.Wait() == 0); // no catching up with burst of frames
+	time += 2000000;
+	CHECK(pacer.Wait() == 8000000);
+}
+
+TEST(FramePacerUnlimited)
+{
+	int64_t time = 0;
+	FramePacer<FakeClock> pacer(FakeClock{ &time });
+	pacer.SetTarget(0);
+	CHECK(pacer.Wait() == 0);
+	CHECK(pacer.Wait() == 0);
+	CHECK(time == 0);
+}
+
+// how close to the ideal cadence real sleeping gets
+static void MeasurePacing(const char* name, PacingStrategy strategy)
+{
+	FramePacer<SteadyClock> pacer;
+	pacer.strategy = strategy;
+	pacer.SetTarget(120);
+
+	const int frames = 120;
+	int64_t worst = 0, total = 0;
+	auto prev = Test::Now();
+	pacer.Wait();
+	for (int i = 0; i < frames; i++)
+	{
+		pacer.Wait();
+		auto now = Test::Now();
+		auto error = now - prev - pacer.GetInterval();
+		error = error < 0 ? -error : error;
+		worst = error > worst ? error : worst;
+		total += error;
+		prev = now;
+	}
+
+	printf("  %-40s %10.3f ms avg error %8.3f ms worst\n", name, total / 1e6 / frames, worst / 1e6);
+}
+
+BENCHMARK(FramePacerAccuracy)
+{
+	MeasurePacing("120 fps, sleep", PacingStrategy::Sleep);
+	MeasurePacing("120 fps, hybrid", PacingStrategy::Hybrid);
+	MeasurePacing("120 fps, busy wait", PacingStrategy::BusyWait);
+}
@@ -0,0 +1,76 @@
+#include "Test.h"
+#include "FrameStats.h"
+
+TEST(FrameTimeHistogramPrecision)
+{
+	for (uint64_t value : { 0ull, 31ull, 1000ull, 16666667ull, 33333333ull, 1000000000ull })
+	{
+		auto bucket = FrameTimeHistogram::BucketValue(FrameTimeHistogram::BucketIndex(value));
+		auto error = bucket > value ? bucket - value : value - bucket;
+		CHECK(error <= value / FrameTimeHistogram::SubBucketCount);
+	}
+
+	FrameTimeHistogram histogram;
+	CHECK(histogram.Percentile(0.5) == 0);
+	for (int i = 1; i <= 1000; i++)
+		histogram.Add(i * 1000000ull);
+
+	CHECK(histogram.GetCount() == 1000);
+	auto p50 = histogram.Percentile(0.5);
+	CHECK(p50 > 485000000 && p50 < 515000000);
+	auto p99 = histogram.Percentile(0.99);
+	CHECK(p99 > 960000000 && p99 < 1020000000);
+
+	histogram.Clear();
+	CHECK(histogram.GetCount() == 0);
+}
+
+TEST(FrameTimeRecorderSummarizesWindow)
+{
+	FrameTimeRecorder recorder;
+	int64_t now = 0;
+	for (int i = 0; i < 100; i++) // old 50 fps frames
+		recorder.Frame(now += 20000000);
+	for (int i = 0; i < 200; i++) // last second at 100 fps
+		recorder.Frame(now += 10000000);
+
+	auto summary = recorder.Summarize(1000000000);
+	CHECK(summary.frames == 100);
+	CHECK(summary.Fps() == 100);
+	CHECK(summary.avg == 10000000 && summary.max == 10000000);
+	CHECK(recorder.Session().GetCount() == 299); // first call only starts measuring
+}
+
+TEST(FrameTimeRecorderRestartSkipsPause)
+{
+	FrameTimeRecorder recorder;
+	recorder.Frame(1000000000);
+	recorder.Frame(1010000000);
+	recorder.Restart(); // device reset or loading in between
+	recorder.Frame(5000000000);
+	recorder.Frame(5010000000);
+
+	auto summary = recorder.Summarize(10000000000);
+	CHECK(summary.frames == 2);
+	CHECK(summary.max == 10000000);
+	CHECK(recorder.Session().GetCount() == 2);
+}
+
+BENCHMARK(FrameTimeRecord)
+{
+	static FrameTimeRecorder recorder;
+	Test::Measure("record frame time", 50000000, [&](uint64_t i) { recorder.Record(16000000 + int64_t(i & 0xffff) * 50); });
+	DoNotOptimize(recorder.Session().GetCount());
+}
+
+BENCHMARK(FrameTimeSummarize)
+{
+	static FrameTimeRecorder recorder;
+	for (uint32_t i = 0; i < FrameTimeRecorder::Capacity; i++)
+		recorder.Record(4000000 + (i % 7) * 100000); // ~240 fps
+
+	FrameTimeSummary summary;
+	Test::Measure("summarize last second (title update)", 20000, [&](uint64_t) { summary = recorder.Summarize(1000000000); });
+	DoNotOptimize(summary);
+	printf("  %-40s %10u frames\n", "", summary.frames);
+}
@@ -0,0 +1,70 @@
+#include "Test.h"
+#include "FrameTrace.h"
+#include <string>
+
+static FrameTraceRecord MakeFrame(int64_t start)
+{
+	return { start, start + 1000, start + 3000, start + 10000 };
+}
+
+static std::string ToJson(const FrameTrace& trace)
+{
+	auto file = tmpfile();
+	trace.WriteJson(file);
+
+	std::string json(ftell(file), '\0');
+	rewind(file);
+	json.resize(fread(json.data(), 1, json.size(), file));
+	fclose(file);
+	return json;
+}
+
+static size_t CountOf(const std::string& text, const char* pattern)
+{
+	size_t count = 0;
+	for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+		count++;
+	return count;
+}
+
+TEST(FrameTraceKeepsNewestRecords)
+{
+	static FrameTrace trace;
+	trace.Clear();
+	for (uint32_t i = 0; i < FrameTrace::Capacity + 10; i++)
+		trace.Add(MakeFrame(i * 20000ll));
+
+	CHECK(trace.GetCount() == FrameTrace::Capacity);
+	CHECK(trace.Get(0).hookEntry == 10 * 20000ll); // oldest ten overwritten
+	CHECK(trace.Get(FrameTrace::Capacity - 1).hookEntry == (FrameTrace::Capacity + 9) * 20000ll);
+
+	trace.Clear();
+	CHECK(trace.GetCount() == 0);
+	trace.Add(MakeFrame(5));
+	CHECK(trace.GetCount() == 1 && trace.Get(0).hookEntry == 5);
+}
+
+TEST(FrameTraceWritesSpans)
+{
+	static FrameTrace trace;
+	trace.Clear();
+	CHECK(ToJson(trace) == "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n\n]}\n");
+
+	trace.Add(MakeFrame(1000000));
+	trace.Add(MakeFrame(1020000));
+	auto json = ToJson(trace);
+
+	CHECK(CountOf(json, "\"name\":\"Hook\"") == 2);
+	CHECK(CountOf(json, "\"name\":\"Present\"") == 2);
+	CHECK(CountOf(json, "\"name\":\"Limiter\"") == 2);
+	CHECK(CountOf(json, "\"name\":\"Game\"") == 1); // only between frames
+	CHECK(json.find("\"name\":\"Hook\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0.000,\"dur\":1.000") != std::string::npos);
+	CHECK(json.find("\"name\":\"Game\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":10.000,\"dur\":10.000") != std::string::npos);
+}
+
+BENCHMARK(FrameTraceAdd)
+{
+	static FrameTrace trace;
+	Test::Measure("record frame trace", 50000000, [&](uint64_t i) { trace.Add(MakeFrame(int64_t(i))); });
+	DoNotOptimize(trace.GetCount());
+}
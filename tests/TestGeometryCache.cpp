@@ -0,0 +1,78 @@
+#include "Fakes.h"
+
+TEST(GeometryCacheQueriesOnce)
+{
+	FakeWindow window;
+	GeometryCache cache(window);
+
+	auto frame = cache.GetFrame(FakeWindow::Captioned, 0);
+	CHECK(frame.left == 8 && frame.top == 31);
+	CHECK(cache.queries == 3); // dpi, monitor, frame
+
+	for (int i = 0; i < 100; i++)
+		cache.GetFrame(FakeWindow::Captioned, 0);
+	CHECK(cache.queries == 3);
+
+	cache.GetFrame(0, 0); // other style
+	CHECK(cache.queries == 4);
+	CHECK(cache.GetFrame(0, 0).top == 0);
+}
+
+TEST(GeometryCacheInvalidate)
+{
+	FakeWindow window;
+	GeometryCache cache(window);
+	cache.GetFrame(FakeWindow::Captioned, 0);
+
+	window.dpi = 144; // not noticed until told
+	CHECK(cache.GetFrame(FakeWindow::Captioned, 0).top == 31);
+
+	cache.Invalidate(); // WM_DPICHANGED
+	CHECK(cache.GetFrame(FakeWindow::Captioned, 0).top == 47);
+	CHECK(cache.queries == 6);
+}
+
+TEST(GeometryCachePaddingRetriedUntilAvailable)
+{
+	FakeWindow window;
+	window.exists = false;
+	GeometryCache cache(window);
+
+	auto padding = cache.GetPadding(FakeWindow::Captioned, 0);
+	CHECK(padding.left == 0 && padding.bottom == 0);
+	auto queries = cache.queries;
+	cache.GetPadding(FakeWindow::Captioned, 0);
+	CHECK(cache.queries == queries + 1); // failure not remembered
+
+	window.exists = true;
+	padding = cache.GetPadding(FakeWindow::Captioned, 0);
+	CHECK(padding.left == 7 && padding.top == 0 && padding.bottom == 7);
+	queries = cache.queries;
+	cache.GetPadding(FakeWindow::Captioned, 0);
+	CHECK(cache.queries == queries);
+}
+
+TEST(ScaleForDpi)
+{
+	CHECK(ScaleForDpi(31, 96, 144) == 47); // 46.5 rounds up like MulDiv
+	CHECK(ScaleForDpi(8, 96, 120) == 10);
+	CHECK(ScaleForDpi(7, 96, 168) == 12); // 12.25
+	CHECK(ScaleForDpi(47, 144, 96) == 31); // 31.33, back where it started
+	CHECK(ScaleForDpi(-7, 96, 144) == -11); // negative rounds away from zero too, -10.5
+	CHECK(ScaleForDpi(-8, 96, 120) == -10);
+	CHECK(ScaleForDpi(0, 96, 192) == 0);
+
+	CHECK(ScaleForDpi(31, 144, 144) == 31); // unchanged
+	CHECK(ScaleForDpi(31, 0, 144) == 31); // unknown source DPI
+	CHECK(ScaleForDpi(30000000, 96, 480) == 150000000); // no overflow
+
+	auto insets = ScaleForDpi(GeometryInsets{ -8, -31, 8, 8 }, 96, 144); // AdjustWindowRectEx result for a captioned window
+	CHECK(insets.left == -12 && insets.top == -47 && insets.right == 12 && insets.bottom == 12);
+}
+
+BENCHMARK(GeometryCacheHit)
+{
+	FakeWindow window;
+	GeometryCache cache(window);
+	Test::Measure("cached frame size", 50000000, [&](uint64_t) { DoNotOptimize(cache.GetFrame(FakeWindow::Captioned, 0)); });
+}
@@ -0,0 +1,201 @@
+#include "Test.h"
+#include "HookThunk.h"
+
+static uint32_t Relative(const uint8_t* code)
+{
+	uint32_t offset;
+	memcpy(&offset, code, sizeof(offset));
+	return offset;
+}
+
+using MinimalRegs = HookRegs<>;
+using EbpRegs = HookRegs<HookReg::ebp>;
+using AllRegs = HookRegs<HookReg::ebx, HookReg::ebp, HookReg::esi, HookReg::edi>;
+
+static_assert(MinimalRegs::Count() == 3 && EbpRegs::Count() == 4 && AllRegs::Count() == 7, "saved register count");
+static_assert(HookThunkBuilder::GetSize(AllRegs::Mask) <= HookThunkBuilder::MaxSize, "largest thunk fits");
+
+TEST(HookThunkLayout)
+{
+	uint8_t code[HookThunkBuilder::MaxSize];
+	const uintptr_t address = 0x401000, callback = 0x402000, returnAddress = 0x400800; // jump back is negative
+	auto size = HookThunkBuilder::Build(code, sizeof(code), address, MinimalRegs::Mask, callback, returnAddress);
+
+	static const uint8_t expected[] =
+	{
+		0x9C, // pushfd
+		0x52, 0x51, 0x50, // push edx, ecx, eax
+		0x54, // push esp
+		0xE8, 0, 0, 0, 0, // call callback
+		0x83, 0xC4, 0x04, // add esp, 4
+		0x58, 0x59, 0x5A, // pop eax, ecx, edx
+		0x9D, // popfd
+		0xE9, 0, 0, 0, 0, // jmp returnAddress
+	};
+	CHECK(size == sizeof(expected) && size == HookThunkBuilder::GetSize(MinimalRegs::Mask));
+	for (size_t i = 0; i < sizeof(expected); i++)
+	{
+		bool relative = (i >= 6 && i < 10) || i >= 18; // targets checked below
+		CHECK(relative || code[i] == expected[i]);
+	}
+
+	CHECK(Relative(code + 6) == uint32_t(callback - (address + 10))); // relative to the next instruction
+	CHECK(Relative(code + 18) == uint32_t(returnAddress - (address + 22)));
+}
+
+TEST(HookThunkSavesListedRegisters)
+{
+	uint8_t code[HookThunkBuilder::MaxSize];
+	auto size = HookThunkBuilder::Build(code, sizeof(code), 0x1000, AllRegs::Mask, 0x2000, 0x3000);
+	CHECK(size == 30);
+
+	// edi pushed first, eax last, so values[] of HookRegs is in encoding order
+	static const uint8_t pushes[] = { 0x57, 0x56, 0x55, 0x53, 0x52, 0x51, 0x50 };
+	static const uint8_t pops[] = { 0x58, 0x59, 0x5A, 0x5B, 0x5D, 0x5E, 0x5F };
+	CHECK(!memcmp(code + 1, pushes, sizeof(pushes)));
+	CHECK(!memcmp(code + 1 + 7 + 1 + 5 + 3, pops, sizeof(pops)));
+
+	size = HookThunkBuilder::Build(code, sizeof(code), 0x1000, EbpRegs::Mask, 0x2000, 0x3000);
+	CHECK(size == HookThunkBuilder::GetSize(EbpRegs::Mask) && code[1] == 0x55 && code[2] == 0x52);
+}
+
+TEST(HookThunkRejects)
+{
+	uint8_t code[HookThunkBuilder::MaxSize];
+	CHECK(HookThunkBuilder::Build(code, 21, 0x1000, MinimalRegs::Mask, 0x2000, 0x3000) == 0); // one byte short
+	CHECK(HookThunkBuilder::Build(code, sizeof(code), 0x1000, MinimalRegs::Mask | 1 << (int)HookReg::esp, 0x2000, 0x3000) == 0);
+}
+
+struct TestPatch
+{
+	using Regs = EbpRegs;
+
+	void operator()(Regs& regs)
+	{
+		regs.Get<HookReg::eax>() = regs.Get<HookReg::ebp>() + 1; // like Patch_InitPresentationParams
+	}
+};
+
+TEST(HookThunkCallbackRegisters)
+{
+	uint32_t values[] = { 10, 20, 30, 40 }; // eax, ecx, edx, ebp as the thunk pushed them
+	HookThunkCallback<TestPatch>::Invoke(values);
+	CHECK(values[0] == 41);
+	CHECK(values[1] == 20 && values[2] == 30 && values[3] == 40);
+
+	AllRegs regs = {};
+	regs.Get<HookReg::edi>() = 7;
+	CHECK(regs.values[6] == 7);
+	regs.Get<HookReg::ebx>() = 3;
+	CHECK(regs.values[3] == 3);
+}
+
+// Runs the emitted thunks, only possible on 32 bit x86. Thunk is called and jumps back to a ret instruction.
+#if defined(__i386__) || defined(_M_IX86)
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <sys/mman.h>
+#include <x86intrin.h>
+#endif
+
+static uint32_t thunkCalls = 0;
+
+template <class Registers>
+struct CountingPatch
+{
+	using Regs = Registers;
+
+	void operator()(Regs&)
+	{
+		thunkCalls++;
+	}
+};
+
+static void HOOK_CDECL CountingRegPack(uint32_t*)
+{
+	thunkCalls++;
+}
+
+// Shape of injector's MakeInline for comparison, not vendored so rebuilt here byte by byte:
+// call at the hooked site into make_reg_pack_and_call, which builds reg_pack with pushad and pushfd.
+// Returns bytes written, site entry is at the start of page.
+static size_t BuildRegPackThunk(uint8_t* page, uintptr_t callback)
+{
+	auto emitRelative = [](uint8_t* code, uint8_t opcode, uintptr_t target)
+	{
+		code[0] = opcode;
+		uint32_t offset = uint32_t(target - (uintptr_t(code) + 5));
+		memcpy(code + 1, &offset, sizeof(offset));
+	};
+
+	// hooked site: call thunk; ret (the code following the hook)
+	auto thunk = page + 8;
+	emitRelative(page, 0xE8, (uintptr_t)thunk);
+	page[5] = 0xC3;
+
+	static const uint8_t head[] =
+	{
+		0x60, // pushad
+		0x83, 0x44, 0x24, 0x0C, 0x04, // add dword ptr [esp+12], 4, reg_pack::esp as before the call
+		0x9C, // pushfd
+		0x54, // push esp
+	};
+	static const uint8_t tail[] =
+	{
+		0x83, 0xC4, 0x04, // add esp, 4
+		0x83, 0x6C, 0x24, 0x10, 0x04, // sub dword ptr [esp+16], 4
+		0x9D, // popfd
+		0x61, // popad
+		0xC3, // ret
+	};
+	memcpy(thunk, head, sizeof(head));
+	emitRelative(thunk + sizeof(head), 0xE8, callback);
+	memcpy(thunk + sizeof(head) + 5, tail, sizeof(tail));
+	return 8 + sizeof(head) + 5 + sizeof(tail);
+}
+
+static void MeasureEntry(const char* name, uint8_t* page)
+{
+	using Entry = void (HOOK_CDECL*)();
+
+	auto thunk = (Entry)page;
+	const uint64_t iterations = 10000000;
+	auto start = __rdtsc();
+	Test::Measure(name, iterations, [&](uint64_t) { thunk(); });
+	printf("  %-40s %10.1f cycles/op\n", "", double(__rdtsc() - start) / iterations);
+}
+
+template <class Patch>
+static void MeasureThunk(const char* name, uint8_t* page)
+{
+	auto ret = page + HookThunkBuilder::MaxSize;
+	*ret = 0xC3; // ret
+	HookThunkBuilder::Build(page, HookThunkBuilder::MaxSize, (uintptr_t)page, Patch::Regs::Mask, (uintptr_t)&HookThunkCallback<Patch>::Invoke, (uintptr_t)ret);
+	MeasureEntry(name, page);
+}
+
+BENCHMARK(HookThunkCycles)
+{
+#if defined(_WIN32)
+	auto page = (uint8_t*)VirtualAlloc(NULL, 4096, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+	auto page = (uint8_t*)mmap(nullptr, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (page == MAP_FAILED) page = nullptr;
+#endif
+	if (!page)
+		return;
+
+	MeasureThunk<CountingPatch<MinimalRegs>>("thunk, volatile registers", page);
+	MeasureThunk<CountingPatch<AllRegs>>("thunk, all registers", page);
+	BuildRegPackThunk(page, (uintptr_t)&CountingRegPack);
+	MeasureEntry("injector MakeInline shape, reg_pack", page);
+	DoNotOptimize(thunkCalls);
+}
+#else
+BENCHMARK(HookThunkCycles)
+{
+	printf("  skipped, thunks only run in 32 bit x86 builds\n");
+}
+#endif
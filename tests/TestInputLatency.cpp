@@ -0,0 +1,108 @@
+#include <math.h>
+#include "Test.h"
+#include "InputLatency.h"
+
+static bool Near(int64_t value, int64_t expected)
+{
+	return fabs(double(value - expected)) <= expected / 32.0 + 1; // histogram bucket resolution
+}
+
+// recorded window thread activity: input events and ends of presents, times in microseconds
+struct RecordedEvent
+{
+	bool present;
+	InputClass type;
+	int64_t time;
+};
+
+static const RecordedEvent recording[] =
+{
+	{ false, InputClass::Keyboard, 1000 },
+	{ false, InputClass::MouseMove, 5000 },
+	{ false, InputClass::MouseMove, 9000 },
+	{ true, InputClass::Count, 17000 }, // keyboard 16 ms, moves 12 and 8 ms
+	{ false, InputClass::MouseButton, 20000 },
+	{ true, InputClass::Count, 33000 }, // button 13 ms
+	{ true, InputClass::Count, 50000 }, // nothing pending
+	{ false, InputClass::Keyboard, 51000 },
+	{ false, InputClass::RawMouse, 60000 },
+	{ true, InputClass::Count, 66000 }, // keyboard 15 ms, raw 6 ms
+};
+
+static void Replay(InputLatencyTracker& tracker)
+{
+	for (auto& event : recording)
+	{
+		if (event.present)
+			tracker.Present(event.time * 1000);
+		else
+			tracker.Input(event.type, event.time * 1000);
+	}
+}
+
+TEST(InputLatencyRecordedStream)
+{
+	InputLatencyTracker tracker;
+	Replay(tracker);
+
+	auto keyboard = tracker.Summarize(InputClass::Keyboard);
+	CHECK(keyboard.events == 2);
+	CHECK(Near(keyboard.p50, 15000000));
+	CHECK(Near(keyboard.p99, 16000000));
+
+	auto move = tracker.Summarize(InputClass::MouseMove);
+	CHECK(move.events == 2);
+	CHECK(Near(move.p50, 8000000) && Near(move.p95, 12000000));
+
+	CHECK(tracker.Summarize(InputClass::MouseButton).events == 1);
+	CHECK(Near(tracker.Summarize(InputClass::MouseButton).p50, 13000000));
+	CHECK(Near(tracker.Summarize(InputClass::RawMouse).p99, 6000000));
+	CHECK(tracker.dropped == 0);
+}
+
+TEST(InputLatencyPercentiles)
+{
+	InputLatencyTracker tracker;
+	for (int i = 1; i <= 100; i++) // latencies 1 - 100 ms, one event per frame
+	{
+		tracker.Input(InputClass::MouseMove, 0);
+		tracker.Present(i * 1000000LL);
+	}
+
+	auto summary = tracker.Summarize(InputClass::MouseMove);
+	CHECK(summary.events == 100);
+	CHECK(Near(summary.p50, 50000000));
+	CHECK(Near(summary.p95, 95000000));
+	CHECK(Near(summary.p99, 99000000));
+	CHECK(tracker.Summarize(InputClass::Keyboard).events == 0);
+	CHECK(tracker.Summarize(InputClass::Keyboard).p99 == 0);
+}
+
+TEST(InputLatencyOverflowAndClear)
+{
+	InputLatencyTracker tracker;
+	for (uint32_t i = 0; i < InputLatencyTracker::MaxPending + 10; i++) // 8 kHz mouse during a long frame
+		tracker.Input(InputClass::RawMouse, 1000);
+	tracker.Input(InputClass::Keyboard, 2000); // other classes have their own queue
+
+	CHECK(tracker.dropped == 10);
+	tracker.Present(-5000); // clock going backwards is clamped
+	CHECK(tracker.Summarize(InputClass::RawMouse).events == InputLatencyTracker::MaxPending);
+	CHECK(tracker.Summarize(InputClass::RawMouse).p50 == 0);
+	CHECK(tracker.Summarize(InputClass::Keyboard).events == 1);
+
+	tracker.Input(InputClass::Keyboard, 0);
+	tracker.Clear();
+	CHECK(tracker.dropped == 0);
+	for (int type = 0; type < (int)InputClass::Count; type++)
+		CHECK(tracker.Summarize((InputClass)type).events == 0);
+
+	tracker.Present(1000000); // pending event was cleared too
+	CHECK(tracker.Summarize(InputClass::Keyboard).events == 0);
+}
+
+TEST(InputLatencyNames)
+{
+	CHECK(!strcmp(InputLatencyTracker::GetName(InputClass::Keyboard), "Keyboard"));
+	CHECK(!strcmp(InputLatencyTracker::GetName(InputClass::RawMouse), "Raw mouse"));
+}
@@ -0,0 +1,73 @@
+#include "Fakes.h"
+
+// filter used before the input state was cached: cursor position in screen coordinates tested against
+// the client rect queried from the system on every message (GetClientRect, ClientToScreen, PtInRect)
+static bool QueriedInClient(FakeWindow& window, PlatformPoint cursor)
+{
+	PlatformRect client;
+	window.GetClientRect(client);
+	return cursor.x >= client.left && cursor.x < client.right && cursor.y >= client.top && cursor.y < client.bottom;
+}
+
+// coordinates as packed into lParam of mouse messages, signed 16 bit each
+static PlatformPoint FromMessage(int32_t x, int32_t y)
+{
+	auto lParam = uint32_t(uint16_t(x)) | uint32_t(uint16_t(y)) << 16;
+	return { (int16_t)(lParam & 0xFFFF), (int16_t)(lParam >> 16) };
+}
+
+TEST(InputStateMatchesQueriedFilter)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	window.displays.push_back({ { -1920, 0, 0, 1080 }, { -1920, 0, 0, 1040 }, 60, 96, false }); // left of the primary
+
+	uint32_t random = 12345, inside = 0, outside = 0;
+	auto next = [&](int32_t range) { random = random * 1664525 + 1013904223; return int32_t((random >> 8) % uint32_t(range)); };
+
+	for (int i = 0; i < 2000; i++)
+	{
+		// window somewhere on the desktop, frame depends on the style
+		window.style = next(2) ? FakeWindow::Captioned : 0;
+		int32_t left = next(4000) - 2000, top = next(1200) - 100;
+		window.rect = { left, top, left + 100 + next(2000), top + 100 + next(1200) };
+		game.UpdateClientRect(); // WM_WINDOWPOSCHANGED
+
+		PlatformRect client;
+		window.GetClientRect(client);
+
+		for (int j = 0; j < 50; j++)
+		{
+			// edges and random points around the client area
+			PlatformPoint cursor;
+			switch (j % 5)
+			{
+				case 0: cursor = { client.left + next(3) - 1, client.top + next(3) - 1 }; break;
+				case 1: cursor = { client.right + next(3) - 2, client.bottom + next(3) - 2 }; break;
+				default: cursor = { client.left - 50 + next(client.right - client.left + 100), client.top - 50 + next(client.bottom - client.top + 100) }; break;
+			}
+
+			bool queried = QueriedInClient(window, cursor);
+			CHECK(game.inputState.IsInClientScreen(FromMessage(cursor.x, cursor.y)) == queried); // wheel messages
+			CHECK(game.inputState.IsInClient(FromMessage(cursor.x - client.left, cursor.y - client.top)) == queried); // move and buttons
+
+			(queried ? inside : outside)++;
+		}
+	}
+
+	CHECK(inside > 10000 && outside > 10000); // both sides covered
+}
+
+TEST(InputStateFocus)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	CHECK(!game.inputState.HasFocus()); // seeded after the window is created
+
+	window.foreground = true;
+	game.inputState.SetFocus(window.IsForeground());
+	CHECK(game.inputState.HasFocus());
+
+	game.inputState.SetFocus(false); // WM_ACTIVATE WA_INACTIVE
+	CHECK(!game.inputState.HasFocus());
+}
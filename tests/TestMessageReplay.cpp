@@ -0,0 +1,93 @@
+#include "MessageReplay.h"
+
+TEST(MessageTracePackedParams)
+{
+	auto point = MessageTrace::UnpackPoint(MessageTrace::PackPoint({ -7, -1 })); // invisible border left of the screen
+	CHECK(point.x == -7 && point.y == -1);
+
+	uint32_t flags;
+	auto size = MessageTrace::UnpackSize(MessageTrace::PackSize({ 3840, 2160 }, WindowController::NoMove | 0x0004), flags);
+	CHECK(size.x == 3840 && size.y == 2160);
+	CHECK(flags == WindowController::NoMove); // other SWP flags are not kept
+}
+
+// records a message the way WindowedMode::WindowProc does, then dispatches what the controller posted
+static void Send(MessageReplay& session, MessageTrace& trace, uint32_t message, uint32_t wParam, uint32_t lParam)
+{
+	auto ticket = trace.Begin(message, wParam, lParam, session.window.time, session.game.GetWork());
+	session.Dispatch(message, wParam, lParam);
+	trace.End(ticket, 0, session.window.time, session.game.GetWork());
+
+	if (message != WindowController::WM_WINDOWEDMODE_COMMANDS && session.game.windowCommandsPosted)
+		Send(session, trace, WindowController::WM_WINDOWEDMODE_COMMANDS, 0, 0);
+}
+
+static void Drag(MessageReplay& session, MessageTrace& trace, PlatformPoint size)
+{
+	session.window.time += 8000000;
+	Send(session, trace, MessageReplay::Sizing, WindowController::EdgeBottomRight, MessageTrace::PackPoint(size));
+	Send(session, trace, MessageReplay::WindowPosChanged, MessageTrace::PackPoint({ -7, 0 }), MessageTrace::PackSize(size, 0));
+	if (session.window.timer)
+		Send(session, trace, MessageReplay::Timer, (uint32_t)session.window.timer, 0);
+}
+
+TEST(MessageReplayMatchesRecording)
+{
+	static MessageTrace trace; // big
+	trace.Clear();
+
+	{
+		MessageReplay session;
+		session.window.time = 1000;
+		Send(session, trace, MessageReplay::Activate, 1, 0);
+		Send(session, trace, MessageReplay::WindowPosChanged, MessageTrace::PackPoint({ 0, 0 }), MessageTrace::PackSize({ 1920, 1080 }, WindowController::NoMove));
+
+		for (int i = 0; i < 20; i++)
+			Drag(session, trace, { 1000 + 10 * i, 700 + 5 * i });
+		Send(session, trace, MessageReplay::ExitSizeMove, 0, 0);
+		Send(session, trace, MessageReplay::Size, WindowController::SizeRestored, (uint32_t)WindowController::MakeSizeParam({ 1174, 756 }));
+
+		Send(session, trace, MessageReplay::GetDpiScaledSize, 144, 0);
+		Send(session, trace, MessageReplay::DpiChanged, 144 | 144 << 16, MessageTrace::PackPoint({ 100, 100 }));
+		Send(session, trace, MessageReplay::DisplayChange, 32, 0);
+		Send(session, trace, 0x0100, 'W', 0); // WM_KEYDOWN, only forwarded
+		Send(session, trace, MessageReplay::Activate, 0, 0);
+	}
+
+	// round trip through the file format
+	FILE* file = tmpfile();
+	if (!file)
+		return;
+	CHECK(trace.Save(file));
+	rewind(file);
+
+	static MessageTrace loaded;
+	CHECK(loaded.Load(file));
+	fclose(file);
+	CHECK(loaded.GetCount() == trace.GetCount());
+
+	MessageReplay replay;
+	MessageReplay::Totals recorded, replayed;
+	replay.Run(loaded, recorded, replayed);
+
+	CHECK(recorded.messages == replayed.messages); // simulated window sends nothing nested
+	CHECK(recorded.geometry == replayed.geometry && replayed.geometry > 0);
+	CHECK(recorded.resets == replayed.resets);
+	CHECK(recorded.platformCalls == replayed.platformCalls && replayed.platformCalls > 0);
+	CHECK(replay.perMessage[MessageReplay::WindowPosChanged].messages == 21);
+	CHECK(replay.window.dpi == 144);
+}
+
+TEST(MessageReplayRejectsOtherFiles)
+{
+	FILE* file = tmpfile();
+	if (!file)
+		return;
+	fputs("not a trace", file);
+	rewind(file);
+
+	static MessageTrace trace;
+	CHECK(!trace.Load(file));
+	CHECK(trace.GetCount() == 0);
+	fclose(file);
+}
@@ -0,0 +1,183 @@
+#include "Fakes.h"
+
+// reference: every monitor checked, nearest one if the point is on none of them
+static int64_t Distance(const PlatformRect& rect, PlatformPoint pos)
+{
+	int64_t dx = pos.x < rect.left ? rect.left - pos.x : pos.x >= rect.right ? pos.x - rect.right + 1 : 0;
+	int64_t dy = pos.y < rect.top ? rect.top - pos.y : pos.y >= rect.bottom ? pos.y - rect.bottom + 1 : 0;
+	return dx * dx + dy * dy;
+}
+
+static int64_t BruteForceDistance(const std::vector<MonitorInfo>& monitors, PlatformPoint pos)
+{
+	int64_t nearest = INT64_MAX;
+	for (auto& monitor : monitors)
+		nearest = std::min(nearest, Distance(monitor.rect, pos));
+	return nearest;
+}
+
+static bool Overlaps(const PlatformRect& a, const PlatformRect& b)
+{
+	return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+TEST(MonitorTopologyMatchesBruteForce)
+{
+	FakeWindow window;
+	MonitorTopology topology(window);
+
+	uint32_t random = 777;
+	auto next = [&](int32_t range) { random = random * 1664525 + 1013904223; return int32_t((random >> 8) % uint32_t(range)); };
+
+	for (int layout = 0; layout < 500; layout++)
+	{
+		// up to 6 monitors of common sizes around the primary one, not overlapping
+		static const PlatformPoint sizes[] = { { 1920, 1080 }, { 2560, 1440 }, { 1280, 1024 }, { 1080, 1920 }, { 3840, 2160 } };
+		window.displays.clear();
+		window.displays.push_back({ { 0, 0, 1920, 1080 }, { 0, 0, 1920, 1040 }, 60, 96, true });
+		for (int tries = next(6) * 4; tries > 0; tries--)
+		{
+			auto& anchor = window.displays[next((int32_t)window.displays.size())].rect;
+			auto size = sizes[next(5)];
+			PlatformRect rect;
+			switch (next(4)) // next to a monitor, aligned or shifted
+			{
+				case 0: rect.left = anchor.right; rect.top = anchor.top + next(600) - 300; break;
+				case 1: rect.left = anchor.left - size.x; rect.top = anchor.top + next(600) - 300; break;
+				case 2: rect.left = anchor.left + next(600) - 300; rect.top = anchor.bottom; break;
+				default: rect.left = anchor.left + next(600) - 300; rect.top = anchor.top - size.y; break;
+			}
+			rect.right = rect.left + size.x;
+			rect.bottom = rect.top + size.y;
+
+			bool free = true;
+			for (auto& monitor : window.displays)
+				free = free && !Overlaps(monitor.rect, rect);
+			if (free)
+				window.displays.push_back({ rect, rect, uint32_t(60 + next(4) * 30), 96, false });
+		}
+		topology.Invalidate(); // WM_DISPLAYCHANGE
+
+		PlatformRect bounds = window.displays[0].rect;
+		for (auto& monitor : window.displays)
+			bounds = { std::min(bounds.left, monitor.rect.left), std::min(bounds.top, monitor.rect.top), std::max(bounds.right, monitor.rect.right), std::max(bounds.bottom, monitor.rect.bottom) };
+
+		for (int i = 0; i < 400; i++)
+		{
+			PlatformPoint pos;
+			if (i % 4 == 0) // monitor corners and edges
+			{
+				auto& rect = window.displays[next((int32_t)window.displays.size())].rect;
+				pos = { (next(2) ? rect.left : rect.right) + next(3) - 1, (next(2) ? rect.top : rect.bottom) + next(3) - 1 };
+			}
+			else
+				pos = { bounds.left - 500 + next(bounds.right - bounds.left + 1000), bounds.top - 500 + next(bounds.bottom - bounds.top + 1000) };
+
+			auto& found = topology.Find(pos);
+			CHECK(Distance(found.rect, pos) == BruteForceDistance(window.displays, pos)); // containing monitor has distance 0
+		}
+	}
+
+	CHECK(topology.rebuilds == 500); // once per layout, not per lookup
+}
+
+TEST(MonitorTopologyRebuildsOnlyWhenInvalidated)
+{
+	FakeWindow window;
+	MonitorTopology topology(window);
+	CHECK(topology.rebuilds == 0); // lazy
+
+	CHECK(topology.GetCount() == 1);
+	uint32_t calls = window.calls;
+	for (int i = 0; i < 100; i++)
+		topology.Find({ i * 10, i * 5 });
+	CHECK(topology.rebuilds == 1);
+	CHECK(window.calls == calls); // lookups don't query the system
+
+	window.displays.push_back({ { 1920, 0, 3840, 1080 }, { 1920, 0, 3840, 1080 }, 144, 96, false });
+	CHECK(topology.GetCount() == 1); // not seen until invalidated
+	topology.Invalidate();
+	CHECK(topology.Find({ 2000, 10 }).refreshRate == 144);
+	CHECK(topology.rebuilds == 2 && window.calls == calls + 1);
+
+	window.displays.clear(); // everything disconnected for a moment
+	topology.Invalidate();
+	CHECK(topology.GetCount() == 2); // previous snapshot kept
+	CHECK(topology.Find({ 2000, 10 }).refreshRate == 144);
+	CHECK(topology.rebuilds == 2);
+
+	window.displays.push_back({ { 0, 0, 2560, 1440 }, { 0, 0, 2560, 1400 }, 75, 96, true });
+	CHECK(topology.Find({ 2000, 10 }).refreshRate == 75); // still invalid, queried again
+	CHECK(topology.rebuilds == 3 && topology.GetCount() == 1);
+}
+
+TEST(MonitorTopologyNeverReported)
+{
+	FakeWindow window;
+	window.displays.clear();
+	MonitorTopology topology(window);
+	CHECK(topology.GetCount() == 0);
+	auto& none = topology.Find({ 0, 0 });
+	CHECK(none.rect.right == none.rect.left && none.refreshRate == 0);
+	CHECK(topology.rebuilds == 0);
+}
+
+TEST(WindowControllerEmptyTopologyKeepsGeometry)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	game.windowMode = WindowController::Fullscreen;
+	game.WindowResize({ 800, 600 });
+	auto backBuffer = game.backBufferSize;
+	CHECK(backBuffer.x == 1920 && backBuffer.y == 1080);
+
+	window.displays.clear();
+	game.OnDisplayChange();
+	game.WindowCalculateGeometry(false, true);
+	CHECK(game.backBufferSize.x == backBuffer.x && game.backBufferSize.y == backBuffer.y); // not 0x0
+	for (auto& size : game.backBuffers)
+		CHECK(size.x > 0 && size.y > 0);
+	CHECK(game.refreshRate == 60);
+
+	// nothing known from the start, the game keeps its own back buffer
+	FakeWindow empty;
+	empty.displays.clear();
+	FakeGameWindow fresh(empty);
+	fresh.windowMode = WindowController::Fullscreen;
+	fresh.WindowResize({ 800, 600 });
+	CHECK(fresh.backBuffers.empty());
+}
+
+TEST(WindowControllerDisplayChangeRebuildsTopology)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	game.windowMode = WindowController::Windowed;
+	game.WindowResize({ 800, 600 });
+	auto rebuilds = game.monitors.rebuilds;
+
+	game.OnWindowPosChanged({ 100, 100 }, { 816, 639 }, 0);
+	game.DrainCommands();
+	CHECK(game.monitors.rebuilds == rebuilds); // moves use the snapshot
+
+	window.displays[0].refreshRate = 120;
+	game.OnDisplayChange();
+	CHECK(game.monitors.rebuilds == rebuilds); // lazy, rebuilt by the next lookup
+	game.UpdateClientRect();
+	game.UpdateClientRect();
+	CHECK(game.monitors.rebuilds == rebuilds + 1);
+	CHECK(game.refreshRate == 120);
+}
+
+BENCHMARK(MonitorTopologyFind)
+{
+	FakeWindow window;
+	window.displays.clear();
+	for (int i = 0; i < 8; i++) // row of monitors
+		window.displays.push_back({ { i * 1920, 0, (i + 1) * 1920, 1080 }, { i * 1920, 0, (i + 1) * 1920, 1040 }, 60, 96, i == 0 });
+
+	MonitorTopology topology(window);
+	uint32_t sum = 0;
+	Test::Measure("find monitor of 8", 20000000, [&](uint64_t i) { sum += topology.Find({ int32_t(i * 7919 % 15360), int32_t(i % 1080) }).refreshRate; });
+	DoNotOptimize(sum);
+}
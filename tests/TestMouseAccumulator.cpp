@@ -0,0 +1,88 @@
+#include <thread>
+#include "Test.h"
+#include "MouseAccumulator.h"
+
+TEST(MouseAccumulatorSums)
+{
+	MouseAccumulator mouse;
+	auto delta = mouse.Sample();
+	CHECK(delta.x == 0 && delta.y == 0 && delta.wheel == 0 && delta.events == 0); // nothing arrived, game keeps its own values
+
+	mouse.Add(5, -3);
+	mouse.Add(-7, 1, 120);
+	delta = mouse.Sample();
+	CHECK(delta.x == -2 && delta.y == -2 && delta.wheel == 120);
+	CHECK(delta.events == 2);
+
+	mouse.Add(0, 0); // event without movement still counts
+	delta = mouse.Sample();
+	CHECK(delta.x == 0 && delta.y == 0 && delta.events == 1);
+	CHECK(mouse.Sample().events == 0);
+}
+
+TEST(MouseAccumulatorNegativeCarry)
+{
+	MouseAccumulator mouse;
+	mouse.Add(-1, 0); // borrows from the packed y half
+	mouse.Add(0, 1);
+	auto delta = mouse.Sample();
+	CHECK(delta.x == -1 && delta.y == 1);
+
+	mouse.Add(-100000, -100000);
+	mouse.Add(30000, 50000);
+	delta = mouse.Sample();
+	CHECK(delta.x == -70000 && delta.y == -50000);
+}
+
+// 8 kHz mouse moving diagonally for one second, game samples at 60 Hz on another thread
+TEST(MouseAccumulatorHighPollingRate)
+{
+	constexpr int Events = 8000;
+	MouseAccumulator mouse;
+	std::atomic<bool> done = false;
+
+	int64_t x = 0, y = 0, wheel = 0;
+	uint32_t events = 0, samples = 0;
+
+	std::thread input([&]
+	{
+		for (int i = 0; i < Events; i++)
+		{
+			mouse.Add(i & 1 ? 3 : -1, -2, i % 800 == 0 ? -120 : 0);
+			if (i % 133 == 0) std::this_thread::yield(); // roughly a frame
+		}
+		done = true;
+	});
+
+	while (!done)
+	{
+		auto delta = mouse.Sample();
+		x += delta.x;
+		y += delta.y;
+		wheel += delta.wheel;
+		events += delta.events;
+		samples++;
+		std::this_thread::yield();
+	}
+	input.join();
+
+	auto delta = mouse.Sample();
+	x += delta.x;
+	y += delta.y;
+	wheel += delta.wheel;
+	events += delta.events;
+
+	CHECK(x == Events / 2 * 3 - Events / 2);
+	CHECK(y == -2 * Events);
+	CHECK(wheel == -120 * 10);
+	CHECK(events == Events); // nothing lost or counted twice
+	CHECK(samples > 0);
+}
+
+BENCHMARK(MouseAccumulatorAdd)
+{
+	MouseAccumulator mouse;
+	Test::Measure("accumulator add", 50000000, [&](uint64_t i) { mouse.Add(int32_t(i & 3) - 1, 1); });
+	auto delta = mouse.Sample();
+	DoNotOptimize(delta);
+}
@@ -0,0 +1,75 @@
+#include "Test.h"
+#include "PatchIntegrity.h"
+
+// classic bit by bit CRC-32, reference for the table driven one
+static uint32_t Crc32Bitwise(const void* data, size_t size)
+{
+	auto bytes = (const uint8_t*)data;
+	uint32_t crc = ~0u;
+	while (size--)
+	{
+		crc ^= *bytes++;
+		for (int i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+TEST(Crc32KnownValues)
+{
+	CHECK(Crc32::Compute("", 0) == 0);
+	CHECK(Crc32::Compute("123456789", 9) == 0xCBF43926);
+	CHECK(Crc32::Compute("The quick brown fox jumps over the lazy dog", 43) == 0x414FA339);
+}
+
+TEST(Crc32MatchesBitwise)
+{
+	uint8_t data[257];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = uint8_t(i * 131 + 7);
+
+	for (size_t offset = 0; offset < 8; offset++) // unaligned starts
+		for (size_t size = 0; size + offset <= sizeof(data); size += 13)
+			CHECK(Crc32::Compute(data + offset, size) == Crc32Bitwise(data + offset, size));
+
+	auto split = Crc32::Compute(data + 100, sizeof(data) - 100, Crc32::Compute(data, 100)); // continued
+	CHECK(split == Crc32::Compute(data, sizeof(data)));
+}
+
+TEST(VerifyPatchSitesReportsAll)
+{
+	static uint8_t code[3][6] = { { 0x55, 0x8B, 0xEC, 0x83, 0xEC, 0x10 }, { 0xE8, 1, 2, 3, 4, 0x90 }, { 0xC3 } };
+	PatchSite sites[] =
+	{
+		{ "first", (uintptr_t)code[0], 6, Crc32::Compute(code[0], 6) },
+		{ "second", (uintptr_t)code[1], 6, Crc32::Compute(code[1], 6) },
+		{ "third", (uintptr_t)code[2], 1, Crc32::Compute(code[2], 1) },
+	};
+
+	size_t reported = 0;
+	CHECK(VerifyPatchSites(sites, 3, [&](const PatchSite&, uint32_t) { reported++; }) == 0);
+	CHECK(reported == 0);
+
+	code[0][0] = 0xE9; // hooked by another mod
+	code[2][0] = 0xCC;
+	const char* names[3] = {};
+	CHECK(VerifyPatchSites(sites, 3, [&](const PatchSite& site, uint32_t hash)
+	{
+		CHECK(hash != site.hash);
+		names[reported++] = site.name;
+	}) == 2);
+	CHECK(reported == 2 && !strcmp(names[0], "first") && !strcmp(names[1], "third"));
+}
+
+BENCHMARK(Crc32)
+{
+	static uint8_t data[4096];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = uint8_t(i * 31);
+
+	uint32_t crc = 0;
+	Test::Measure("slice-by-8, 4 KiB", 100000, [&](uint64_t) { crc ^= Crc32::Compute(data, sizeof(data)); });
+	Test::Measure("bitwise, 4 KiB", 5000, [&](uint64_t) { crc ^= Crc32Bitwise(data, sizeof(data)); });
+	Test::Measure("slice-by-8, 6 byte patch site", 20000000, [&](uint64_t i) { crc ^= Crc32::Compute(data + (i & 63), 6); });
+	DoNotOptimize(crc);
+}
@@ -0,0 +1,139 @@
+#include "Fakes.h"
+#include <set>
+
+// Three pages of code, all protected until opened. Can be told to fail opening a page or to drop writes.
+class PagedPatchMemory : public FakePatchMemory
+{
+public:
+	alignas(PatchMemory::PageSize) uint8_t code[3 * PatchMemory::PageSize];
+	std::set<uintptr_t> open;
+	uint32_t unprotects = 0;
+	uint32_t flushes = 0;
+	uintptr_t failPage = 0; // Unprotect fails for it
+	uintptr_t readOnly = 0; // writes into this address are ignored
+
+	PagedPatchMemory()
+	{
+		memset(code, 0xCC, sizeof(code));
+	}
+
+	uintptr_t Page(int index)
+	{
+		return uintptr_t(code) + index * PatchMemory::PageSize;
+	}
+
+	bool Unprotect(uintptr_t page, uint32_t& oldProtection) override
+	{
+		unprotects++;
+		if (page == failPage)
+			return false;
+
+		oldProtection = 0x20; // PAGE_EXECUTE_READ
+		open.insert(page);
+		return true;
+	}
+
+	void Protect(uintptr_t page, uint32_t protection) override
+	{
+		CHECK(protection == 0x20);
+		CHECK(open.erase(page) == 1);
+	}
+
+	void FlushCode(uintptr_t, size_t) override
+	{
+		flushes++;
+	}
+
+	void Write(uintptr_t address, const void* data, size_t size) override
+	{
+		CHECK(open.count(address & ~(PageSize - 1)) && open.count((address + size - 1) & ~(PageSize - 1)));
+		if (address != readOnly)
+			FakePatchMemory::Write(address, data, size);
+	}
+};
+
+static void Target()
+{
+}
+
+TEST(PatchTransactionOpensEachPageOnce)
+{
+	PagedPatchMemory memory;
+	auto a = memory.Page(0) + 0x10;
+	auto b = memory.Page(0) + 0x40; // same page
+	auto c = memory.Page(1) - 2; // crosses into the second page
+
+	const PatchOp ops[] =
+	{
+		PatchOp::Write(a, uint16_t(0x9090)),
+		PatchOp::MakeNOP(b, 3),
+		PatchOp::MakeJMP(c, &Target, 6),
+	};
+
+	PatchTransaction transaction(memory);
+	CHECK(transaction.Apply(ops) == PatchTransaction::Success);
+	CHECK(memory.unprotects == 2);
+	CHECK(transaction.protectCalls == 4); // open and close per page
+	CHECK(memory.open.empty());
+	CHECK(memory.flushes == 1);
+
+	CHECK(*(uint8_t*)b == 0x90 && *(uint8_t*)(b + 3) == 0xCC);
+	CHECK(*(uint8_t*)c == 0xE9 && *(uint8_t*)(c + 5) == 0x90);
+	if constexpr (sizeof(uintptr_t) == 4) // rel32 reaches anywhere only in 32 bit address space
+	{
+		int32_t offset;
+		memcpy(&offset, (void*)(c + 1), 4);
+		CHECK(uintptr_t(c + 5 + offset) == uintptr_t(&Target));
+	}
+}
+
+TEST(PatchTransactionRejectsInvalid)
+{
+	PagedPatchMemory memory;
+	PatchTransaction transaction(memory);
+
+	const PatchOp overlapping[] = { PatchOp::MakeNOP(memory.Page(0), 4), PatchOp::MakeNOP(memory.Page(0) + 3, 2) };
+	CHECK(transaction.Apply(overlapping) == PatchTransaction::InvalidPatch);
+
+	const PatchOp shortJump[] = { PatchOp::MakeJMP(memory.Page(0), &Target, 4) };
+	CHECK(transaction.Apply(shortJump) == PatchTransaction::InvalidPatch);
+
+	const PatchOp empty[] = { PatchOp::MakeNOP(memory.Page(0), 0) };
+	CHECK(transaction.Apply(empty) == PatchTransaction::InvalidPatch);
+
+	CHECK(memory.unprotects == 0 && transaction.protectCalls == 0); // nothing touched
+}
+
+TEST(PatchTransactionRollsBack)
+{
+	PagedPatchMemory memory;
+	const PatchOp ops[] =
+	{
+		PatchOp::MakeNOP(memory.Page(0), 8),
+		PatchOp::MakeNOP(memory.Page(2), 8),
+	};
+
+	memory.failPage = memory.Page(2);
+	PatchTransaction transaction(memory);
+	CHECK(transaction.Apply(ops) == PatchTransaction::ProtectFailed);
+	CHECK(memory.open.empty()); // first page closed again
+	CHECK(*(uint8_t*)memory.Page(0) == 0xCC);
+
+	memory.failPage = 0;
+	memory.readOnly = memory.Page(2); // second write does not stick
+	CHECK(transaction.Apply(ops) == PatchTransaction::WriteFailed);
+	CHECK(*(uint8_t*)memory.Page(0) == 0xCC); // first one reverted
+	CHECK(memory.open.empty());
+}
+
+BENCHMARK(PatchTransactionApply)
+{
+	static PagedPatchMemory memory;
+	PatchOp ops[16];
+	for (int i = 0; i < 16; i++)
+		ops[i] = PatchOp::MakeNOP(memory.Page(i % 3) + 0x100 * (i / 3), 6);
+
+	PatchTransaction transaction(memory);
+	Test::Measure("16 patches on 3 pages", 200000, [&](uint64_t) { transaction.Apply(ops); });
+	printf("  %-40s %10u protection changes\n", "", transaction.protectCalls);
+}
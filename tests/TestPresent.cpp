@@ -0,0 +1,192 @@
+#include "Fakes.h"
+#include "FramePresenter.h"
+
+static_assert(DeviceVTable<false>::Reset == 14 && DeviceVTable<false>::Present == 15, "IDirect3DDevice8 slots");
+static_assert(DeviceVTable<true>::Reset == 16 && DeviceVTable<true>::Present == 17, "IDirect3DDevice9 slots");
+
+// hooks installed into the fake device, same shape as WindowedMode's D3D hooks
+template <bool D3D9>
+struct DeviceHooks
+{
+	using Device = FakeDevice<D3D9>;
+
+	static inline typename Device::PresentFunc presentOri = nullptr;
+	static inline typename Device::ResetFunc resetOri = nullptr;
+	static inline uint32_t presents = 0;
+	static inline uint32_t resets = 0;
+
+	// work of the real present hook, set by the benchmark
+	static inline FramePresenter<SteadyClock>* presenter = nullptr;
+	static inline WindowController* controller = nullptr;
+
+	static long FAKE_STDCALL Present(Device* self, const void* srcRect, const void* dstRect, void* wnd, const void* region)
+	{
+		presents++;
+		if (!presenter)
+			return presentOri(self, srcRect, dstRect, wnd, region);
+
+		auto prepare = [](bool) {};
+		auto present = [&](const ScaleRect* rect) { return presentOri(self, srcRect, rect ? rect : dstRect, wnd, region); };
+		return presenter->Frame(*controller, !dstRect, false, prepare, present);
+	}
+
+	static long FAKE_STDCALL Reset(Device* self, void* parameters)
+	{
+		resets++;
+		return resetOri(self, parameters);
+	}
+
+	static bool Install(Device& device)
+	{
+		PatchOp patches[2];
+		auto original = DeviceVTable<D3D9>::Redirect(device.vTable, { (uintptr_t)&Reset, (uintptr_t)&Present }, patches);
+		resetOri = (typename Device::ResetFunc)original.reset;
+		presentOri = (typename Device::PresentFunc)original.present;
+
+		FakePatchMemory memory;
+		return PatchTransaction(memory).Apply(patches) == PatchTransaction::Success;
+	}
+};
+
+template <bool D3D9>
+static void CheckRedirect()
+{
+	using Hooks = DeviceHooks<D3D9>;
+	FakeDevice<D3D9> device;
+	auto otherReset = DeviceVTable<!D3D9>::Reset;
+	auto otherPresent = DeviceVTable<!D3D9>::Present;
+	auto untouched = device.vTable[otherReset];
+
+	CHECK(Hooks::Install(device));
+	CHECK(device.vTable[DeviceVTable<D3D9>::Present] == (uintptr_t)&Hooks::Present);
+	CHECK(device.vTable[DeviceVTable<D3D9>::Reset] == (uintptr_t)&Hooks::Reset);
+	CHECK(device.vTable[otherReset] == untouched); // slots of the other version are left alone
+	CHECK(device.vTable[otherPresent] == untouched);
+
+	Hooks::presents = Hooks::resets = 0;
+	CHECK(device.CallPresent() == 0);
+	CHECK(device.CallReset(nullptr) == 0);
+	CHECK(Hooks::presents == 1 && device.presents == 1);
+	CHECK(Hooks::resets == 1 && device.resets == 1);
+	CHECK(device.unexpected == 0);
+
+	device.CallSlot(otherReset);
+	CHECK(device.unexpected == 1);
+}
+
+TEST(DeviceVTableRedirectD3D8)
+{
+	CheckRedirect<false>();
+}
+
+TEST(DeviceVTableRedirectD3D9)
+{
+	CheckRedirect<true>();
+}
+
+TEST(FramePresenterSkipsPresentWhenMinimized)
+{
+	int64_t time = 0;
+	FramePresenter<FakeClock> presenter(FakeClock{ &time });
+	presenter.focusThrottle.OnMinimize(true);
+
+	uint32_t presents = 0;
+	FrameTraceRecord trace;
+	presenter.Begin(trace);
+	presenter.Present(trace, [&] { presents++; return 0L; });
+	presenter.End(trace, false);
+
+	CHECK(presents == 0);
+	CHECK(presenter.frameTrace.GetCount() == 1);
+
+	presenter.focusThrottle.OnMinimize(false);
+	presenter.Begin(trace);
+	presenter.Present(trace, [&] { presents++; return 0L; });
+	presenter.End(trace, false);
+	CHECK(presents == 1);
+}
+
+TEST(FramePresenterLimitsPerContext)
+{
+	int64_t time = 0;
+	FramePresenter<FakeClock> presenter(FakeClock{ &time });
+	auto& limiter = presenter.frameLimiter;
+	limiter.pacer.strategy = PacingStrategy::Sleep; // spinning would never see the fake time move
+	limiter.targets[limiter.Gameplay] = 100;
+	limiter.targets[limiter.Menu] = 50;
+
+	FrameTraceRecord trace;
+	for (int i = 0; i < 10; i++) // gameplay frames take no time, limiter fills the rest
+	{
+		presenter.Begin(trace);
+		presenter.End(trace, false);
+	}
+	CHECK(time >= 9 * 10000000 && time <= 10 * 10000000);
+
+	time = 0;
+	presenter.frameLimiter.pacer.Reset();
+	for (int i = 0; i < 10; i++)
+	{
+		presenter.Begin(trace);
+		presenter.End(trace, true);
+	}
+	CHECK(time >= 9 * 20000000 && time <= 10 * 20000000);
+}
+
+// Presents as fast as possible through the hooked virtual table while the window is being dragged:
+// every few frames a window move arrives and gets dispatched like by the game's message loop,
+// resets are coalesced by the controller.
+template <bool D3D9>
+static void PresentStorm(const char* name)
+{
+	using Hooks = DeviceHooks<D3D9>;
+	FakeDevice<D3D9> device;
+	if (!Hooks::Install(device))
+		return;
+
+	static FramePresenter<SteadyClock> presenter; // big ring buffers
+	FakeWindow window;
+	FakeGameWindow game(window);
+	game.windowMode = WindowController::Windowed;
+	game.WindowResize({ 800, 600 });
+
+	Hooks::presenter = &presenter;
+	Hooks::controller = &game;
+
+	Test::Measure(name, 2000000, [&](uint64_t i)
+	{
+		if ((i & 15) == 0)
+		{
+			window.time = Test::Now();
+			game.OnWindowPosChanged({ -7, 0 }, { 816 + int32_t(i & 255), 639 }, 0);
+			for (auto& message : window.posted)
+				if (message.message == WindowController::WM_WINDOWEDMODE_COMMANDS)
+					game.DrainCommands();
+			window.posted.clear();
+			if (window.timer)
+				game.OnTimer(window.timer);
+		}
+		device.CallPresent();
+	});
+
+	Hooks::presenter = nullptr;
+	Hooks::controller = nullptr;
+	printf("  %-40s %10u presents %6zu resets forwarded\n", "", device.presents, window.forwarded.size());
+}
+
+BENCHMARK(PresentStormD3D8)
+{
+	PresentStorm<false>("present hook, D3D8 slots");
+}
+
+BENCHMARK(PresentStormD3D9)
+{
+	PresentStorm<true>("present hook, D3D9 slots");
+}
+
+BENCHMARK(PresentUnhooked)
+{
+	FakeDevice<true> device;
+	Test::Measure("original present only", 20000000, [&](uint64_t) { device.CallPresent(); });
+	DoNotOptimize(device.presents);
+}
@@ -0,0 +1,54 @@
+#include "Test.h"
+#include "PresentScaler.h"
+
+TEST(ScaleToFitPolicies)
+{
+	CHECK(ScaleToFit(640, 480, 1920, 1080, ScalePolicy::Fill) == ScaleRect({ 0, 0, 1920, 1080 }));
+	CHECK(ScaleToFit(640, 480, 1920, 1080, ScalePolicy::AspectFit) == ScaleRect({ 240, 0, 1680, 1080 })); // pillarbox
+	CHECK(ScaleToFit(1920, 1080, 1024, 768, ScalePolicy::AspectFit) == ScaleRect({ 0, 96, 1024, 672 })); // letterbox
+	CHECK(ScaleToFit(640, 480, 1920, 1080, ScalePolicy::IntegerScale) == ScaleRect({ 320, 60, 1600, 1020 })); // 2x
+	CHECK(ScaleToFit(1920, 1080, 1024, 768, ScalePolicy::IntegerScale) == ScaleToFit(1920, 1080, 1024, 768, ScalePolicy::AspectFit));
+	CHECK(ScaleToFit(800, 600, 800, 600, ScalePolicy::IntegerScale) == ScaleRect({ 0, 0, 800, 600 }));
+}
+
+TEST(ScaleToFitDegenerate)
+{
+	CHECK(ScaleToFit(0, 480, 800, 600, ScalePolicy::AspectFit) == ScaleRect({ 0, 0, 800, 600 }));
+	CHECK(ScaleToFit(640, 480, 0, 0, ScalePolicy::AspectFit) == ScaleRect({ 0, 0, 0, 0 }));
+
+	auto rect = ScaleToFit(1, 1000, 1000, 1, ScalePolicy::AspectFit); // never inverted
+	CHECK(rect.Width() >= 0 && rect.Height() == 1);
+}
+
+TEST(MapToSourceInvertsScale)
+{
+	auto rect = ScaleToFit(640, 480, 1920, 1080, ScalePolicy::AspectFit);
+
+	int32_t x = 240, y = 0; // top left corner of the image
+	MapToSource(rect, 640, 480, x, y);
+	CHECK(x == 0 && y == 0);
+
+	x = 960, y = 540; // center
+	MapToSource(rect, 640, 480, x, y);
+	CHECK(x == 320 && y == 240);
+
+	x = 10, y = 2000; // on the black bar and below the window, clamped
+	MapToSource(rect, 640, 480, x, y);
+	CHECK(x == 0 && y == 479);
+
+	x = 5, y = 5; // nothing to map into
+	MapToSource({ 0, 0, 0, 0 }, 640, 480, x, y);
+	CHECK(x == 5 && y == 5);
+}
+
+BENCHMARK(MapToSource)
+{
+	auto rect = ScaleToFit(640, 480, 1920, 1080, ScalePolicy::AspectFit);
+	Test::Measure("map mouse position", 50000000, [&](uint64_t i)
+	{
+		int32_t x = int32_t(i % 1920), y = int32_t(i % 1080);
+		MapToSource(rect, 640, 480, x, y);
+		DoNotOptimize(x);
+		DoNotOptimize(y);
+	});
+}
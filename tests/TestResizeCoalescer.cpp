@@ -0,0 +1,59 @@
+#include "Test.h"
+#include "ResizeCoalescer.h"
+
+static constexpr int64_t Ms = 1000000;
+
+TEST(ResizeCoalescerWaitsForSettle)
+{
+	ResizeCoalescer coalescer;
+	coalescer.SetApplied({ 800, 600 });
+
+	ResizeCoalescer::Size size = {};
+	for (int i = 1; i <= 30; i++) // dragging the edge, new size every frame
+		coalescer.Resize({ 800 + i, 600 }, i * 16 * Ms);
+	CHECK(coalescer.requests == 30);
+	CHECK(!coalescer.Poll(30 * 16 * Ms + 100 * Ms, size));
+
+	CHECK(coalescer.Poll(30 * 16 * Ms + coalescer.settleTime, size));
+	CHECK(size == ResizeCoalescer::Size({ 830, 600 }));
+	CHECK(coalescer.GetApplied() == ResizeCoalescer::Size({ 800, 600 })); // until the game gets told
+	CHECK(coalescer.commits == 1); // thirty sizes, one device reset
+	CHECK(!coalescer.Poll(10000 * Ms, size));
+}
+
+TEST(ResizeCoalescerEndDragReleasesImmediately)
+{
+	ResizeCoalescer coalescer;
+	coalescer.SetApplied({ 800, 600 });
+	coalescer.Resize({ 1024, 768 }, 1000 * Ms);
+
+	ResizeCoalescer::Size size;
+	CHECK(!coalescer.Poll(1001 * Ms, size));
+	coalescer.EndDrag(1001 * Ms);
+	CHECK(coalescer.Poll(1001 * Ms, size));
+	CHECK(size.width == 1024 && size.height == 768);
+}
+
+TEST(ResizeCoalescerReturnToApplied)
+{
+	ResizeCoalescer coalescer;
+	coalescer.SetApplied({ 800, 600 });
+	coalescer.Resize({ 900, 600 }, 0);
+	CHECK(coalescer.IsPending());
+	CHECK(coalescer.GetPending().width == 900);
+
+	coalescer.Resize({ 800, 600 }, 10 * Ms); // dragged back
+	CHECK(!coalescer.IsPending());
+
+	ResizeCoalescer::Size size;
+	CHECK(!coalescer.Poll(1000 * Ms, size));
+	CHECK(coalescer.requests == 2 && coalescer.commits == 0);
+}
+
+TEST(ResizeCoalescerSetAppliedDropsPending)
+{
+	ResizeCoalescer coalescer;
+	coalescer.Resize({ 640, 480 }, 0);
+	coalescer.SetApplied({ 640, 480 }); // device reset by the game with that size
+	CHECK(!coalescer.IsPending());
+}
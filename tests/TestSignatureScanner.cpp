@@ -0,0 +1,195 @@
+#include "Test.h"
+#include "SignatureScanner.h"
+#include <string>
+
+// image as mapped by the loader: headers, a data section and the code section
+static std::vector<uint8_t> MakeImage(size_t textSize, uint32_t timeStamp = 0)
+{
+	const uint32_t header = 0x80, optionalSize = 0xE0, textAddress = 0x1000;
+	std::vector<uint8_t> image(textAddress + textSize);
+	auto write16 = [&](uint32_t offset, uint16_t value) { memcpy(&image[offset], &value, sizeof(value)); };
+	auto write32 = [&](uint32_t offset, uint32_t value) { memcpy(&image[offset], &value, sizeof(value)); };
+
+	write16(0, 0x5A4D); // MZ
+	write32(0x3C, header);
+	write32(header, 0x00004550); // PE\0\0
+	write16(header + 6, 2); // sections
+	write32(header + 8, timeStamp);
+	write16(header + 20, optionalSize);
+	write32(header + 24 + 56, (uint32_t)image.size()); // SizeOfImage
+
+	auto sections = header + 24 + optionalSize;
+	memcpy(&image[sections], ".data", 5);
+	write32(sections + 8, 0x200);
+	write32(sections + 12, 0x400);
+	memcpy(&image[sections + 40], ".text", 5);
+	write32(sections + 40 + 8, (uint32_t)textSize);
+	write32(sections + 40 + 12, textAddress);
+	return image;
+}
+
+static void FillRandom(uint8_t* data, size_t size, uint32_t& random, uint32_t range = 256)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		random = random * 1664525 + 1013904223;
+		data[i] = uint8_t((random >> 16) % range);
+	}
+}
+
+// reference: every position compared byte by byte
+static const uint8_t* FindNaive(const char* pattern, const uint8_t* begin, const uint8_t* end)
+{
+	BytePattern signature(pattern);
+	for (auto pos = begin; signature.IsValid() && pos + signature.size() <= end; pos++)
+	{
+		if (signature.Matches(pos)) return pos;
+	}
+	return nullptr;
+}
+
+TEST(BytePatternParse)
+{
+	BytePattern pattern("8B 0D ?? ?? ?? ?? 85 C9");
+	CHECK(pattern.IsValid() && pattern.size() == 8);
+
+	const uint8_t code[] = { 0x8B, 0x0D, 1, 2, 3, 4, 0x85, 0xC9 };
+	CHECK(pattern.Matches(code));
+	CHECK(BytePattern("8b0d?85").IsValid() && BytePattern("8b0d?85").size() == 4); // lowercase, no spaces, single ?
+
+	CHECK(!BytePattern("").IsValid());
+	CHECK(!BytePattern("8G").IsValid()); // not hex
+	CHECK(!BytePattern("8").IsValid()); // half a byte
+	CHECK(!BytePattern("?? ??").IsValid()); // nothing to anchor on
+
+	std::string tooLong;
+	for (size_t i = 0; i <= BytePattern::MaxLength; i++)
+		tooLong += "90 ";
+	CHECK(!BytePattern(tooLong.c_str()).IsValid());
+}
+
+TEST(BytePatternMatchesNaive)
+{
+	uint32_t random = 99;
+	std::vector<uint8_t> data(4096);
+	FillRandom(data.data(), data.size(), random, 4); // few distinct bytes, lots of partial matches
+
+	auto next = [&](uint32_t range) { random = random * 1664525 + 1013904223; return (random >> 8) % range; };
+
+	for (int i = 0; i < 3000; i++)
+	{
+		// pattern copied from the data or made up, wildcards at the ends too
+		auto length = 1 + next(24);
+		auto source = data.data() + next(uint32_t(data.size() - length + 1));
+		bool copied = next(4) != 0;
+
+		std::string text;
+		for (uint32_t j = 0; j < length; j++)
+		{
+			char byte[4];
+			snprintf(byte, sizeof(byte), "%02X ", copied ? source[j] : next(4));
+			text += next(5) == 0 ? "?? " : byte;
+		}
+
+		// ranges starting and ending anywhere, so the SSE2 loop and the scalar tail both see matches
+		auto begin = data.data() + next(64);
+		auto end = data.data() + data.size() - next(64);
+		CHECK(BytePattern(text.c_str()).Find(begin, end) == FindNaive(text.c_str(), begin, end));
+	}
+
+	// match in the last possible position
+	memcpy(&data[data.size() - 5], "\x11\x22\x33\x44\x55", 5);
+	CHECK(BytePattern("11 22 ?? 44 55").Find(data.data(), data.data() + data.size()) == &data[data.size() - 5]);
+	CHECK(!BytePattern("11 22 ?? 44 55").Find(data.data(), data.data() + data.size() - 1));
+}
+
+TEST(PeImageSections)
+{
+	auto image = MakeImage(0x2000);
+	PeImage pe(image.data());
+	CHECK(pe.IsValid());
+
+	const uint8_t* begin = nullptr;
+	const uint8_t* end = nullptr;
+	CHECK(pe.GetSection(".text", begin, end));
+	CHECK(begin == image.data() + 0x1000 && end == begin + 0x2000);
+	CHECK(!pe.GetSection(".bss", begin, end));
+
+	CHECK(pe.GetHash() == PeImage(image.data()).GetHash());
+	auto rebuilt = MakeImage(0x2000, 1); // other build of the same size
+	CHECK(pe.GetHash() != PeImage(rebuilt.data()).GetHash());
+
+	image[0] = 0;
+	CHECK(!PeImage(image.data()).IsValid());
+}
+
+TEST(SignatureResolverCache)
+{
+	auto image = MakeImage(0x10000);
+	uint32_t random = 7;
+	FillRandom(&image[0x1000], 0x10000, random);
+	const uint8_t call[] = { 0xFF, 0x15, 0x78, 0x56, 0x34, 0x12 };
+	memcpy(&image[0x9000], call, sizeof(call));
+
+	SignatureResolver resolver(image.data());
+	auto address = resolver.Resolve("CreateWindowExA call", "FF 15 78 56 34 12");
+	CHECK(address == uintptr_t(&image[0x9000]));
+	CHECK(resolver.Resolve("CreateWindowExA call", "FF 15 78 56 34 12") == address);
+	CHECK(resolver.Resolve("CreateWindowExA call", "FF 15 78 56 34 12", 2) == address + 2); // other offset is another entry
+	CHECK(resolver.Resolve("Missing", "FF 15 00 00 00 00 C3 C3 C3 C3") == 0);
+	CHECK(resolver.scans == 3 && resolver.cacheHits == 1);
+	CHECK(resolver.IsCacheModified());
+
+	FILE* file = tmpfile();
+	if (!file)
+		return;
+	CHECK(resolver.SaveCache(file));
+	CHECK(!resolver.IsCacheModified());
+
+	// next launch: nothing is scanned, misses are remembered too
+	rewind(file);
+	SignatureResolver cached(image.data());
+	CHECK(cached.LoadCache(file));
+	CHECK(cached.Resolve("CreateWindowExA call", "FF 15 78 56 34 12") == address);
+	CHECK(cached.Resolve("Missing", "FF 15 00 00 00 00 C3 C3 C3 C3") == 0);
+	CHECK(cached.scans == 0 && cached.cacheHits == 2);
+	CHECK(!cached.IsCacheModified());
+
+	// changed signature under the same name is scanned for again
+	memcpy(&image[0xA000], call, sizeof(call));
+	image[0xA005] = 0x13;
+	CHECK(cached.Resolve("CreateWindowExA call", "FF 15 78 56 34 13") == uintptr_t(&image[0xA000]));
+	CHECK(cached.scans == 1);
+
+	// cache of another executable is not used
+	rewind(file);
+	auto other = MakeImage(0x10000, 1);
+	SignatureResolver otherResolver(other.data());
+	CHECK(!otherResolver.LoadCache(file));
+	CHECK(otherResolver.Resolve("CreateWindowExA call", "FF 15 78 56 34 12") == 0);
+	CHECK(otherResolver.scans == 1);
+	fclose(file);
+}
+
+BENCHMARK(SignatureScan)
+{
+	const size_t textSize = 8 << 20; // same order as the code sections of the games
+	static auto image = MakeImage(textSize);
+	uint32_t random = 1;
+	FillRandom(&image[0x1000], textSize, random);
+
+	const char* pattern = "FF 15 ?? ?? ?? ?? 85 C0 74 ?? 8B";
+	const uint8_t tail[] = { 0xFF, 0x15, 1, 2, 3, 4, 0x85, 0xC0, 0x74, 5, 0x8B };
+	memcpy(&image[image.size() - 64], tail, sizeof(tail)); // near the end, whole section is scanned
+
+	auto begin = image.data() + 0x1000, end = image.data() + image.size();
+	BytePattern signature(pattern);
+	CHECK(signature.Find(begin, end) == FindNaive(pattern, begin, end));
+
+	Test::Measure("scan 8 MiB, naive", 10, [&](uint64_t) { DoNotOptimize(FindNaive(pattern, begin, end)); });
+	Test::Measure("scan 8 MiB, anchor bytes", 50, [&](uint64_t) { DoNotOptimize(signature.Find(begin, end)); });
+
+	SignatureResolver resolver(image.data());
+	resolver.Resolve("call", pattern);
+	Test::Measure("resolve from cache", 10000000, [&](uint64_t) { DoNotOptimize(resolver.Resolve("call", pattern)); });
+}
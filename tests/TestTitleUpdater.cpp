@@ -0,0 +1,92 @@
+#include "Test.h"
+#include "TitleUpdater.h"
+#include <mutex>
+#include <string>
+
+TEST(TitleTextFormats)
+{
+	TitleText text;
+	text.Append("GTA3").Append(" | ").Append(uint32_t(1920)).Append('x').Append(uint32_t(1080));
+	text.Append(" ").AppendMs(16666667).Append(" ").AppendMs(40000).Append(" ").AppendMs(-5);
+	CHECK(!strcmp(text.c_str(), "GTA3 | 1920x1080 16.7 0.0 0.0"));
+	CHECK(text.size() == strlen(text.c_str()));
+
+	text.Clear();
+	CHECK(text.size() == 0 && !strcmp(text.c_str(), ""));
+}
+
+TEST(TitleTextTruncates)
+{
+	TitleText text;
+	for (int i = 0; i < 100; i++)
+		text.Append("abc").Append(uint32_t(123456));
+
+	CHECK(text.size() == TitleText::Capacity - 1);
+	CHECK(strlen(text.c_str()) == TitleText::Capacity - 1);
+}
+
+struct TitleReceiver
+{
+	std::mutex mutex;
+	std::vector<std::string> applied;
+
+	static void Apply(void* context, const char* text)
+	{
+		auto receiver = (TitleReceiver*)context;
+		std::lock_guard<std::mutex> lock(receiver->mutex);
+		receiver->applied.push_back(text);
+	}
+
+	std::string Last()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return applied.empty() ? "" : applied.back();
+	}
+};
+
+TEST(TitleUpdaterAppliesLatest)
+{
+	static TitleReceiver receiver; // helper thread outlives the test
+	static TitleUpdater updater(&TitleReceiver::Apply, &receiver);
+
+	TitleText text;
+	text.Append("first");
+	CHECK(updater.Post(text));
+	CHECK(!updater.Post(text)); // same text again
+
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		text.Clear();
+		text.Append("frame ").Append(i);
+		updater.Post(text);
+	}
+
+	for (int i = 0; i < 1000 && receiver.Last() != "frame 999"; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	CHECK(receiver.Last() == "frame 999");
+
+	std::lock_guard<std::mutex> lock(receiver.mutex);
+	CHECK(receiver.applied.size() <= 1001); // busy helper skips to the newest
+}
+
+BENCHMARK(TitleFormat)
+{
+	TitleText text;
+	Test::Measure("TitleText", 5000000, [&](uint64_t i)
+	{
+		text.Clear();
+		text.Append("GTA: Vice City").Append(" | ").Append(uint32_t(1920)).Append('x').Append(uint32_t(1080)).Append(" (16:9)")
+			.Append(" @ ").Append(uint32_t(i & 255)).Append(" fps")
+			.Append(" | avg ").AppendMs(16666667).Append(" p50 ").AppendMs(16600000).Append(" p99 ").AppendMs(20000000)
+			.Append(" p99.9 ").AppendMs(33000000).Append(" max ").AppendMs(int64_t(i)).Append(" ms");
+		DoNotOptimize(text);
+	});
+
+	char buffer[TitleText::Capacity];
+	Test::Measure("snprintf", 5000000, [&](uint64_t i)
+	{
+		snprintf(buffer, sizeof(buffer), "%s | %ux%u (%s) @ %u fps | avg %.1f p50 %.1f p99 %.1f p99.9 %.1f max %.1f ms",
+			"GTA: Vice City", 1920u, 1080u, "16:9", unsigned(i & 255), 16.7, 16.6, 20.0, 33.0, i / 1e6);
+		DoNotOptimize(buffer);
+	});
+}
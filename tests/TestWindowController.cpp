@@ -0,0 +1,289 @@
+#include "Fakes.h"
+
+// controller with 800x600 client area in the top left corner of the simulated desktop, device created
+static void SetupWindowed(FakeGameWindow& game)
+{
+	game.windowMode = WindowController::Windowed;
+	game.WindowResize({ 800, 600 });
+	game.BeforeDeviceCreate();
+}
+
+static bool Equal(PlatformPoint a, PlatformPoint b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+TEST(WindowControllerFullscreenGeometry)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	game.windowMode = WindowController::Fullscreen;
+
+	game.WindowCalculateGeometry(true);
+
+	CHECK(Equal(game.windowSize, { 1920, 1080 }));
+	CHECK(Equal(game.windowSizeClient, { 1920, 1080 }));
+	CHECK(Equal(game.backBufferSize, { 1920, 1080 }));
+	CHECK(game.backBuffers.size() == 1);
+	CHECK(game.refreshRate == 60);
+	CHECK(window.moves == 0); // window not touched unless asked for
+}
+
+TEST(WindowControllerResizeMovesWindow)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	CHECK(Equal(game.windowSize, { 816, 639 }));
+	CHECK(Equal(game.windowSizeClient, { 800, 600 }));
+	CHECK(Equal(game.backBufferSize, { 800, 600 }));
+	CHECK(window.moves == 1);
+	CHECK(window.rect.left == -7 && window.rect.top == 0); // invisible border left of the screen
+	CHECK(window.rect.right == 809 && window.rect.bottom == 639);
+	CHECK(window.style == FakeWindow::Captioned);
+}
+
+TEST(WindowControllerCoalescesResize)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	// user drags the edge, window procedure sees the new rect
+	game.OnWindowPosChanged({ -7, 0 }, { 916, 739 }, 0);
+	CHECK(window.posted.size() == 1 && window.posted[0].message == WindowController::WM_WINDOWEDMODE_COMMANDS);
+	game.OnWindowPosChanged({ -7, 0 }, { 916, 739 }, 0);
+	CHECK(window.posted.size() == 1); // one message until drained
+	game.DrainCommands();
+
+	CHECK(Equal(game.windowSizeClient, { 900, 700 }));
+	CHECK(Equal(game.backBufferSize, { 800, 600 })); // device not reset yet
+	CHECK(game.resizeCoalescer.IsPending());
+	CHECK(window.timer == WindowController::ResizeTimer);
+
+	ScaleRect rect;
+	CHECK(game.GetPresentRect(rect) && rect == ScaleRect({ 0, 0, 900, 700 })); // old back buffer stretched meanwhile
+
+	PlatformPoint size = { 900, 700 };
+	CHECK(!game.ForwardSize(WindowController::SizeRestored, size)); // game learns about it once settled
+	CHECK(window.forwarded.empty());
+
+	window.time += 100000000;
+	CHECK(game.OnTimer(WindowController::ResizeTimer));
+	CHECK(window.forwarded.empty());
+	CHECK(window.timer == WindowController::ResizeTimer);
+
+	window.time += 60000000;
+	game.OnTimer(WindowController::ResizeTimer);
+	CHECK(Equal(game.backBufferSize, { 900, 700 }));
+	CHECK(window.forwarded.size() == 1);
+	CHECK(window.forwarded[0].message == WindowController::SizeMessage);
+	CHECK(window.forwarded[0].lParam == WindowController::MakeSizeParam({ 900, 700 }));
+	CHECK(game.resizeCoalescer.GetApplied().width == 900);
+	CHECK(window.timer == 0);
+	CHECK(!game.GetPresentRect(rect));
+
+	CHECK(game.ForwardSize(WindowController::SizeRestored, size));
+	CHECK(!game.OnTimer(1)); // game's own timer
+}
+
+TEST(WindowControllerEndDragKeepsHeldBackSize)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	game.OnWindowPosChanged({ -7, 0 }, { 916, 739 }, 0);
+	game.OnExitSizeMove(); // EndDrag and Recalculate, window gets moved again
+	game.DrainCommands();
+
+	CHECK(window.forwarded.size() == 1); // released without waiting, not dropped by the recalculation
+	CHECK(window.forwarded[0].lParam == WindowController::MakeSizeParam({ 900, 700 }));
+	CHECK(game.resizeCoalescer.GetApplied().width == 900 && !game.resizeCoalescer.IsPending());
+	CHECK(Equal(game.backBufferSize, { 900, 700 }));
+}
+
+TEST(WindowControllerDeviceResetAppliesPendingSize)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	game.OnWindowPosChanged({ -7, 0 }, { 916, 739 }, 0);
+	game.BeforeDeviceReset({ 800, 600 }); // game resets for its own reasons, drains first
+	CHECK(Equal(game.backBufferSize, { 900, 700 }));
+	CHECK(!game.resizeCoalescer.IsPending());
+	CHECK(game.resizeCoalescer.GetApplied().width == 900);
+	CHECK(game.GetWork().resets == 1);
+}
+
+TEST(WindowControllerResetOffWindowThreadQueued)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+	auto moves = window.moves;
+
+	std::thread([&] { game.BeforeDeviceReset({ 1024, 768 }); }).join();
+	CHECK(window.moves == moves); // nothing touched from the other thread
+	CHECK(game.GetWork().resets == 0);
+
+	game.DrainCommands();
+	CHECK(game.GetWork().resets == 1);
+	CHECK(Equal(game.windowSizeClient, { 1024, 768 }));
+	CHECK(window.moves == moves + 1);
+
+	std::thread([&] { game.DrainCommands(); }).join(); // ignored off the window thread
+}
+
+TEST(WindowControllerFilterSize)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	PlatformPoint size = { 800, 600 };
+	CHECK(game.FilterSize(WindowController::SizeRestored, size));
+	CHECK(!game.FilterSize(WindowController::SizeMinimized, size));
+	CHECK(!game.FilterSize(WindowController::SizeMaxHide, size));
+
+	game.renderScale = 0.5f; // game sees the back buffer size
+	game.BeforeDeviceCreate(); // device recreated at the new scale
+	size = { 800, 600 };
+	CHECK(game.FilterSize(WindowController::SizeRestored, size));
+	CHECK(Equal(size, { 400, 300 }));
+}
+
+TEST(WindowControllerSizingSnapsToAspectRatio)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	PlatformRect rect = { 0, 0, 816, 452 + 39 }; // client 800x452, close to 16:9
+	game.OnSizing(WindowController::EdgeRight, rect);
+	CHECK(rect.right == 803 + 16);
+	CHECK(rect.bottom == 452 + 39);
+
+	rect = { 0, 0, 816, 1039 }; // client 800x1000, no known ratio
+	game.OnSizing(WindowController::EdgeBottomRight, rect);
+	CHECK(rect.right == 816 && rect.bottom == 1039);
+	CHECK(game.titleUpdates >= 2);
+}
+
+TEST(WindowControllerOverflowReadsWindowRect)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	for (int i = 0; i < 65; i++)
+		game.PushCommand({ WindowController::WindowCommand::Moved, 0, { 0, 0 }, { 816 + i, 639 } });
+	CHECK(game.windowCommandsOverflow);
+
+	window.rect = { -7, 0, 1007, 739 }; // where the window really is
+	game.DrainCommands();
+
+	CHECK(!game.windowCommandsOverflow);
+	CHECK(Equal(game.windowPos, { 0, 0 }));
+	CHECK(Equal(game.windowSizeClient, { 998, 700 }));
+	CHECK(game.resizeCoalescer.GetPending().width == 998);
+}
+
+TEST(WindowControllerFixedBackBufferInvalidates)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+	game.fixedBackBuffer = true;
+	game.fixedBackBufferSize = { 640, 480 };
+	game.BeforeDeviceCreate();
+
+	game.OnWindowPosChanged({ -7, 0 }, { 916, 739 }, 0);
+	game.DrainCommands();
+
+	CHECK(window.invalidations == 1); // black bars repainted
+	CHECK(Equal(game.BackBufferFromClient(game.windowSizeClient), { 640, 480 }));
+	CHECK(!game.resizeCoalescer.IsPending()); // back buffer stays, no reset needed
+
+	auto rect = game.PresentRect();
+	CHECK(rect.left == 0 && rect.right == 900); // aspect fit into 900x700
+	CHECK(rect.top == 12 && rect.bottom == 687);
+}
+
+TEST(WindowControllerDpiChangeKeepsClientSize)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	auto size = game.GetDpiScaledSize(144);
+	CHECK(Equal(size, { 824, 659 }));
+
+	auto moves = window.moves;
+	window.dpi = 144;
+	game.OnDpiChanged(144, { 100, 100 });
+	CHECK(window.moves == moves + 1);
+	CHECK(window.rect.left == 100 && window.rect.right == 924 && window.rect.bottom == 759);
+}
+
+TEST(WindowControllerPlatformCallsCounted)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	CHECK(window.calls > 0);
+	CHECK(game.GetWork().platformCalls == window.calls);
+	CHECK(game.GetWork().geometry == 2); // window resize, device creation
+
+	uint32_t calls = window.calls;
+	window.Now(); // reading the clock is free
+	CHECK(window.calls == calls);
+}
+
+TEST(FindAspectRatio)
+{
+	CHECK(!strcmp(WindowController::AspectRatios[WindowController::FindAspectRatio({ 1920, 1080 })].name, "16:9"));
+	CHECK(!strcmp(WindowController::AspectRatios[WindowController::FindAspectRatio({ 640, 448 })].name, "10:7"));
+	CHECK(WindowController::FindAspectRatio({ 1000, 900 }) == -1);
+	CHECK(WindowController::FindAspectRatio({ 1000, 900 }, 0.2f) != -1);
+}
+
+TEST(WindowControllerRenderScale)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+
+	game.renderScale = 1.5f;
+	game.WindowCalculateGeometry();
+	CHECK(Equal(game.backBufferSize, { 1200, 900 }));
+	CHECK(Equal(game.windowSizeClient, { 800, 600 })); // window stays
+	CHECK(game.IsBackBufferScaled());
+	CHECK(game.PresentRect() == ScaleRect({ 0, 0, 800, 600 })); // stretched over the client area
+
+	game.renderScale = 3.0f; // out of range values from the ini are clamped
+	CHECK(Equal(game.BackBufferFromClient({ 800, 600 }), { 1600, 1200 }));
+	game.renderScale = 0.1f;
+	CHECK(Equal(game.BackBufferFromClient({ 800, 600 }), { 400, 300 }));
+	CHECK(Equal(game.BackBufferFromClient({ 1, 1 }), { 1, 1 })); // never empty
+
+	game.renderScale = 1.0f;
+	game.WindowCalculateGeometry();
+	CHECK(!game.IsBackBufferScaled());
+}
+
+TEST(WindowControllerRenderScaleResizeFollowsWindow)
+{
+	FakeWindow window;
+	FakeGameWindow game(window);
+	SetupWindowed(game);
+	game.renderScale = 0.5f;
+	game.WindowCalculateGeometry();
+
+	game.OnWindowPosChanged({ -7, 0 }, { 1016, 639 }, 0);
+	game.DrainCommands();
+	CHECK(game.resizeCoalescer.GetPending().width == 500 && game.resizeCoalescer.GetPending().height == 300);
+}
@@ -0,0 +1,120 @@
+#include "Fakes.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Fake window whose posted messages cross threads like a real message queue. Run under the TSan
+// configuration this checks that only the command queue, posted messages and published values are shared.
+class ThreadedWindow : public FakeWindow
+{
+public:
+	void Post(uint32_t message, uintptr_t wParam, intptr_t lParam) override
+	{
+		calls++;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back({ message, wParam, lParam });
+		}
+		ready.notify_one();
+	}
+
+	// window thread, false if nothing arrived in time
+	bool WaitMessage(Message& message, std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!ready.wait_for(lock, timeout, [this] { return !queue.empty(); }))
+			return false;
+
+		message = queue.front();
+		queue.pop_front();
+		return true;
+	}
+
+protected:
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<Message> queue;
+};
+
+TEST(WindowControllerThreadStress)
+{
+	ThreadedWindow window; // this thread owns it
+	FakeGameWindow game(window);
+	game.windowMode = WindowController::Windowed;
+	game.WindowResize({ 800, 600 });
+	game.BeforeDeviceCreate();
+
+	constexpr int Frames = 20000;
+	constexpr int Resolutions = 200;
+	std::atomic<int> running = 2;
+	std::atomic<uint32_t> resetRequests = 0;
+	std::atomic<uint32_t> tornRects = 0;
+
+	// options menu picking resolutions on the game thread
+	std::thread gameThread([&]
+	{
+		for (int i = 0; i < Resolutions; i++)
+		{
+			game.PushCommand({ WindowController::WindowCommand::Resize, 0, {}, { 640 + (i % 8) * 40, 480 + (i % 8) * 30 } });
+			std::this_thread::yield();
+		}
+		running--;
+	});
+
+	// presents reading the published rect, resetting now and then
+	std::thread renderThread([&]
+	{
+		uint32_t refreshSum = 0;
+		for (int i = 0; i < Frames; i++)
+		{
+			ScaleRect rect;
+			if (game.GetPresentRect(rect) && (rect.left > rect.right || rect.top > rect.bottom || rect.Width() > 4096))
+				tornRects++;
+			refreshSum += game.refreshRate;
+
+			if (i % 100 == 0)
+			{
+				game.BeforeDeviceReset({ 800, 600 });
+				resetRequests++;
+			}
+		}
+		DoNotOptimize(refreshSum);
+		running--;
+	});
+
+	// window thread: dispatches posted messages, user drags the window edge meanwhile
+	auto dispatch = [&]
+	{
+		FakeWindow::Message message;
+		if (!window.WaitMessage(message, std::chrono::milliseconds(20)))
+			return false;
+
+		if (message.message == WindowController::WM_WINDOWEDMODE_COMMANDS)
+			game.DrainCommands();
+		return true;
+	};
+
+	uint32_t drags = 0;
+	while (running)
+	{
+		window.time = Test::Now();
+		if (drags < 2000)
+			game.OnWindowPosChanged({ -7, 0 }, { 816 + int32_t(drags++ % 100), 639 }, 0);
+
+		dispatch();
+		if (window.timer)
+			game.OnTimer(window.timer);
+	}
+
+	gameThread.join();
+	renderThread.join();
+	while (dispatch());
+
+	WindowController::WindowCommand command;
+	CHECK(!game.windowCommands.Pop(command)); // every queued command had a message on the way
+	CHECK(!game.windowCommandsPosted);
+	CHECK(tornRects == 0);
+	CHECK(!game.windowCommandsOverflow);
+	CHECK(game.GetWork().resets > 0 && game.GetWork().resets <= resetRequests);
+	CHECK(game.windowSizeClient.x > 0 && game.windowSizeClient.y > 0);
+}
@@ -0,0 +1,69 @@
+#include "Test.h"
+#include "MessageReplay.h"
+
+// replays message trace saved by the plugin, prints work done per message
+static int Replay(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		printf("can't open %s\n", path);
+		return 1;
+	}
+
+	auto trace = new MessageTrace;
+	bool loaded = trace->Load(file);
+	fclose(file);
+	if (!loaded)
+	{
+		printf("%s is not a message trace\n", path);
+		delete trace;
+		return 1;
+	}
+
+	auto replay = new MessageReplay;
+	MessageReplay::Totals recorded, replayed;
+	replay->Run(*trace, recorded, replayed);
+	replay->Print(recorded, replayed);
+
+	delete replay;
+	delete trace;
+	return 0;
+}
+
+// usage: Tests [--bench] [name filter]
+//        Tests --replay III.VC.SA.WindowedMode.messages.bin
+int main(int argc, char** argv)
+{
+	bool benchmarks = false;
+	const char* filter = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--bench"))
+			benchmarks = true;
+		else if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+			return Replay(argv[i + 1]);
+		else
+			filter = argv[i];
+	}
+
+	uint32_t count = 0;
+	for (auto& test : Test::Cases())
+	{
+		if (test.benchmark != benchmarks || (filter && !strstr(test.name, filter)))
+			continue;
+
+		printf("%s\n", test.name);
+		fflush(stdout);
+
+		auto failures = Test::failures;
+		test.func();
+		if (Test::failures != failures)
+			printf("  FAILED\n");
+		count++;
+	}
+
+	printf("%u %s, %u failed checks\n", count, benchmarks ? "benchmarks" : "tests", Test::failures);
+	return Test::failures ? 1 : 0;
+}